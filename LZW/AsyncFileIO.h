@@ -0,0 +1,270 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <vector>
+
+#include "FileIO.h"
+
+//Queue between threads, push waits while capacity values are in queue
+template <typename T>
+class BoundedQueue
+{
+public:
+	explicit BoundedQueue(std::size_t capacity) : capacity{ capacity } {}
+
+	void push(T value)
+	{
+		{
+			std::unique_lock lock{ mutex };
+			not_full.wait(lock, [this] { return queue.size() < capacity; });
+
+			queue.push_back(std::move(value));
+		}
+
+		not_empty.notify_one();
+	}
+
+	T pop()
+	{
+		T value{};
+
+		{
+			std::unique_lock lock{ mutex };
+			not_empty.wait(lock, [this] { return !queue.empty(); });
+
+			value = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		not_full.notify_one();
+
+		return value;
+	}
+
+private:
+	const std::size_t capacity;
+
+	std::mutex mutex{};
+	std::condition_variable not_empty{};
+	std::condition_variable not_full{};
+	std::deque<T> queue{};
+};
+
+//FileIO with prefetching reader thread and write-behind writer thread
+//Both threads use fixed pool of buffers, so memory usage is bounded
+class AsyncFileIO
+{
+public:
+	//Offsets are the same as in FileIO
+	AsyncFileIO(std::string_view input_file, std::string_view output_file, IOMode mode, bool asynchronous, std::uint64_t input_offset = 0, std::uint64_t output_offset = 0);
+	AsyncFileIO(const AsyncFileIO&) = delete;
+	AsyncFileIO(AsyncFileIO&&) = delete;
+	AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+	AsyncFileIO& operator=(AsyncFileIO&&) = delete;
+
+	~AsyncFileIO();
+
+	//While writer runs, only it touches file_IO output, so its errors are read from write_failed
+	bool isValid() const { return writer.joinable() ? !write_failed : file_IO.isValid(); }
+
+	//Same as FileIO::read, [begin, end) is valid until next read
+	bool read(const unsigned char*& begin, const unsigned char*& end);
+
+	//Data is swapped with empty buffer from pool and written in background
+	//Returns false if output can't be written, in background mode error of earlier write is returned
+	bool write(std::vector<unsigned char>& data);
+
+	//Wait until all output is written, returns false if any write failed
+	bool finish();
+
+	std::size_t outputBufferSize() const
+	{
+		return asynchronous ? async_buffer_size : file_IO.outputBufferSize();
+	}
+
+private:
+	struct InputPart
+	{
+		std::vector<unsigned char>* storage{};
+		const unsigned char* begin{};
+		const unsigned char* end{};
+	};
+
+	void readerLoop();
+	void writerLoop();
+
+	//Writer writes all buffers which it got before
+	void stopWriter();
+
+	FileIO file_IO;
+	const bool asynchronous;
+
+	//Number of buffers in every pool
+	static constexpr std::size_t pool_size = 3;
+	static constexpr std::size_t async_buffer_size = 16 * 1024 * 1024;
+
+	std::vector<unsigned char> input_storage[pool_size]{};
+	std::vector<unsigned char> output_storage[pool_size]{};
+
+	//Every buffer of pool and empty value which ends the other thread fit to queue
+	BoundedQueue<std::vector<unsigned char>*> free_input{ pool_size + 1 };
+	BoundedQueue<InputPart> ready_input{ pool_size + 1 };
+	BoundedQueue<std::vector<unsigned char>*> free_output{ pool_size + 1 };
+	BoundedQueue<std::vector<unsigned char>*> ready_output{ pool_size + 1 };
+
+	InputPart current{};
+	bool input_finished{ false };
+	std::atomic<bool> stop_reading{ false };
+	std::atomic<bool> write_failed{ false };
+
+	std::thread reader{};
+	std::thread writer{};
+};
+
+inline AsyncFileIO::AsyncFileIO(std::string_view input_file, std::string_view output_file, IOMode mode, bool asynchronous, std::uint64_t input_offset, std::uint64_t output_offset)
+	: file_IO{ input_file, output_file, mode, input_offset, output_offset }, asynchronous{ asynchronous }
+{
+	if (!asynchronous || !file_IO.isValid())
+		return;
+
+	file_IO.setPartSize(async_buffer_size);
+
+	for (std::size_t i = 0; i < pool_size; i++)
+	{
+		input_storage[i].reserve(async_buffer_size);
+		output_storage[i].reserve(async_buffer_size + async_buffer_size / 4);
+
+		free_input.push(&input_storage[i]);
+		free_output.push(&output_storage[i]);
+	}
+
+	reader = std::thread{ &AsyncFileIO::readerLoop, this };
+	writer = std::thread{ &AsyncFileIO::writerLoop, this };
+}
+
+inline AsyncFileIO::~AsyncFileIO()
+{
+	stopWriter();
+
+	if (reader.joinable())
+	{
+		stop_reading = true;
+
+		//Reader can wait for free buffer, so give it all back
+		if (current.storage)
+			free_input.push(current.storage);
+
+		while (!input_finished)
+		{
+			auto part = ready_input.pop();
+			if (!part.storage)
+				break;
+
+			free_input.push(part.storage);
+		}
+
+		reader.join();
+	}
+}
+
+inline bool AsyncFileIO::read(const unsigned char*& begin, const unsigned char*& end)
+{
+	if (!asynchronous)
+		return file_IO.read(begin, end);
+
+	if (input_finished)
+		return false;
+
+	if (current.storage)
+	{
+		file_IO.release(current.begin, current.end);
+		free_input.push(current.storage);
+	}
+
+	current = ready_input.pop();
+
+	if (!current.storage)
+	{
+		input_finished = true;
+		return false;
+	}
+
+	begin = current.begin;
+	end = current.end;
+
+	return true;
+}
+
+inline bool AsyncFileIO::write(std::vector<unsigned char>& data)
+{
+	if (!asynchronous)
+		return file_IO.write(data);
+
+	auto buffer = free_output.pop();
+	buffer->swap(data);
+	ready_output.push(buffer);
+
+	return !write_failed;
+}
+
+inline bool AsyncFileIO::finish()
+{
+	stopWriter();
+
+	return file_IO.finish();
+}
+
+inline void AsyncFileIO::stopWriter()
+{
+	if (writer.joinable())
+	{
+		//Empty buffer stops writer
+		ready_output.push(nullptr);
+		writer.join();
+	}
+}
+
+inline void AsyncFileIO::readerLoop()
+{
+	for (;;)
+	{
+		InputPart part{ free_input.pop() };
+
+		if (stop_reading || !file_IO.read(*part.storage, part.begin, part.end))
+		{
+			free_input.push(part.storage);
+			ready_input.push({});
+			return;
+		}
+
+		//Mapped input is not copied, so fault pages in before coder needs them
+		volatile unsigned char touch{};
+		for (std::size_t i = 0; i < static_cast<std::size_t>(part.end - part.begin); i += 4096)
+		{
+			touch = part.begin[i];
+		}
+		(void)touch;
+
+		ready_input.push(part);
+	}
+}
+
+inline void AsyncFileIO::writerLoop()
+{
+	for (;;)
+	{
+		auto buffer = ready_output.pop();
+		if (!buffer)
+			return;
+
+		//After error buffers are only recycled, so producer is never blocked
+		if (!file_IO.write(*buffer))
+			write_failed = true;
+
+		free_output.push(buffer);
+	}
+}
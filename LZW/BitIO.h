@@ -0,0 +1,447 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace BitIOHelper
+{
+	//Number of leading zeros, val != 0
+	inline std::uint32_t countLeadingZeros(std::uint64_t val)
+	{
+#ifdef _MSC_VER
+		unsigned long index{};
+		_BitScanReverse64(&index, val);
+		return 63 - index;
+#else
+		return __builtin_clzll(val);
+#endif
+	}
+
+	//Reverse bytes, words are stored big endian on little endian host
+	inline std::uint64_t byteSwap(std::uint64_t val)
+	{
+#ifdef _MSC_VER
+		return _byteswap_uint64(val);
+#else
+		return __builtin_bswap64(val);
+#endif
+	}
+}
+
+//Code is lowest length bits of high:low, length <= 128
+struct Codeword
+{
+	std::uint64_t high{};
+	std::uint64_t low{};
+	std::uint32_t length{};
+};
+
+//Bits are stored most significant first, so every code can be appended as one integer
+class BitWriter
+{
+public:
+	void write(const Codeword& code)
+	{
+		if (code.length > 64)
+		{
+			write(code.high, code.length - 64);
+			write(code.low, 64);
+		}
+		else
+		{
+			write(code.low, code.length);
+		}
+	}
+
+	//Append lowest length bits of bits, length <= 64
+	void write(std::uint64_t bits, std::uint32_t length)
+	{
+		if (length > 32)
+		{
+			put(bits >> 32, length - 32);
+			bits &= 0xFFFFFFFFull;
+			length = 32;
+		}
+
+		put(bits, length);
+	}
+
+	//Append size codes at once, lowest lengths[i] bits of values[i], 0 < length <= 64
+	//Position of every code is prefix sum of lengths before it, so codes are packed to whole 64 bit words without branches
+	void write(const std::uint64_t* values, const std::uint32_t* lengths, std::size_t size)
+	{
+		//Every code ends in its word or the next one
+		reserve(8 * (size + 2));
+		auto out = buffer.data() + pos;
+
+		//Bits which are not in buffer yet go first
+		std::uint64_t word = count ? tailBits() << (64 - count) : 0;
+		std::uint64_t offset{ count };
+		std::size_t index{};
+
+		for (std::size_t i = 0; i < size; i++)
+		{
+			auto length = lengths[i];
+			auto value = values[i];
+			auto end = offset % 64 + length;
+
+			word |= value << (64 - length) >> (offset % 64);
+			storeWord(out + 8 * index, word);
+
+			//Code which reaches next word starts it, shift is masked, so it is valid also when it doesn't
+			auto next = end > 64 ? value << ((128 - end) & 63) : 0;
+			auto crossed = end >= 64;
+			word = crossed ? next : word;
+			index += crossed;
+			offset += length;
+		}
+
+		storeWord(out + 8 * index, word);
+		total += offset - count;
+
+		//Whole 32 bit words stay in buffer, rest goes to accumulator like after put
+		auto stored = offset / 32;
+		pos += 4 * stored;
+		count = static_cast<std::uint32_t>(offset % 32);
+		acc = count ? static_cast<std::uint32_t>(word >> (stored % 2 ? 0 : 32)) >> (32 - count) : 0;
+	}
+
+	//Fill last byte with fill bit
+	void align(bool fill)
+	{
+		auto padding = (8 - count % 8) % 8;
+		put(fill ? (1ull << padding) - 1 : 0, padding);
+
+		while (count >= 8)
+		{
+			count -= 8;
+			store8(static_cast<unsigned char>(acc >> count));
+		}
+	}
+
+	//Append whole bytes, writer has to be aligned
+	void writeBytes(const unsigned char* data, std::size_t size)
+	{
+		while (count >= 8)
+		{
+			count -= 8;
+			store8(static_cast<unsigned char>(acc >> count));
+		}
+
+		reserve(size);
+		std::memcpy(buffer.data() + pos, data, size);
+		pos += size;
+		total += 8 * static_cast<std::uint64_t>(size);
+	}
+
+	//Number of bits written since creation
+	std::uint64_t written() const
+	{
+		return total;
+	}
+
+	//Number of whole bytes in buffer
+	std::size_t size() const
+	{
+		return pos;
+	}
+
+	//Buffer with all whole bytes, caller has to empty it
+	//Bits which don't form whole byte stay in writer
+	std::vector<unsigned char>& flush()
+	{
+		buffer.resize(pos);
+		pos = 0;
+
+		return buffer;
+	}
+
+	//Bits which are not in buffer yet, at most 31
+	std::uint32_t tailLength() const
+	{
+		return count;
+	}
+
+	std::uint64_t tailBits() const
+	{
+		return count ? acc & ((1ull << count) - 1) : 0;
+	}
+
+	//Continue stream of total_bits bits, which was written by other writer until its tail
+	void resume(std::uint64_t total_bits, std::uint64_t tail_bits, std::uint32_t tail_length)
+	{
+		acc = tail_bits;
+		count = tail_length;
+		total = total_bits;
+	}
+
+private:
+	void put(std::uint64_t bits, std::uint32_t length)
+	{
+		//count < 32 and length <= 32, so it never overflows
+		acc = (acc << length) | bits;
+		count += length;
+		total += length;
+
+		if (count >= 32)
+		{
+			count -= 32;
+			store32(static_cast<std::uint32_t>(acc >> count));
+		}
+	}
+
+	//Store 64 bits most significant byte first
+	static void storeWord(unsigned char* ptr, std::uint64_t word)
+	{
+		word = BitIOHelper::byteSwap(word);
+		std::memcpy(ptr, &word, sizeof(word));
+	}
+
+	void reserve(std::size_t bytes)
+	{
+		if (pos + bytes > buffer.size())
+		{
+			buffer.resize(std::max<std::size_t>({ buffer.size() * 2, pos + bytes, 4096 }));
+		}
+	}
+
+	void store32(std::uint32_t word)
+	{
+		reserve(4);
+
+		auto ptr = buffer.data() + pos;
+		ptr[0] = static_cast<unsigned char>(word >> 24);
+		ptr[1] = static_cast<unsigned char>(word >> 16);
+		ptr[2] = static_cast<unsigned char>(word >> 8);
+		ptr[3] = static_cast<unsigned char>(word);
+		pos += 4;
+	}
+
+	void store8(unsigned char byte)
+	{
+		reserve(1);
+		buffer[pos++] = byte;
+	}
+
+	std::uint64_t acc{};
+	std::uint32_t count{};
+	std::uint64_t total{};
+
+	std::vector<unsigned char> buffer{};
+	std::size_t pos{};
+};
+
+//Input for BitReader from memory
+class MemoryInput
+{
+public:
+	MemoryInput(const unsigned char* begin, const unsigned char* end) : begin{ begin }, end{ end } {}
+
+	bool read(const unsigned char*& part_begin, const unsigned char*& part_end)
+	{
+		if (begin == end)
+			return false;
+
+		part_begin = begin;
+		part_end = end;
+		begin = end;
+
+		return true;
+	}
+
+private:
+	const unsigned char* begin;
+	const unsigned char* end;
+};
+
+//Reads bits written by BitWriter, input parts are pulled from Source::read
+template <typename Source>
+class BitReader
+{
+public:
+	BitReader(Source& source) : source{ source } {}
+
+	//Try to have at least n bits in buffer, n <= 56
+	bool ensure(std::uint32_t n)
+	{
+		if (count < n)
+			refill();
+
+		return count >= n;
+	}
+
+	//Next n bits, 0 < n <= 56, missing bits are 0
+	std::uint64_t peek(std::uint32_t n)
+	{
+		ensure(n);
+		return bits >> (64 - n);
+	}
+
+	//n <= available bits
+	void skip(std::uint32_t n)
+	{
+		bits = n < 64 ? bits << n : 0;
+		count -= n;
+	}
+
+	//Read n bits, n <= 64
+	bool read(std::uint32_t n, std::uint64_t& value)
+	{
+		if (n > 56)
+		{
+			std::uint64_t low{};
+			if (!read(n - 32, value) || !read(32, low))
+				return false;
+
+			value = (value << 32) | low;
+			return true;
+		}
+
+		if (n == 0)
+		{
+			value = 0;
+			return true;
+		}
+
+		if (!ensure(n))
+			return false;
+
+		value = bits >> (64 - n);
+		skip(n);
+
+		return true;
+	}
+
+	//Consume zeros before next 1
+	bool readZeros(std::uint32_t& zeros)
+	{
+		zeros = 0;
+
+		for (;;)
+		{
+			ensure(56);
+
+			if (bits != 0)
+			{
+				//Bits after count are always 0, so first 1 is in buffer
+				auto n = BitIOHelper::countLeadingZeros(bits);
+				zeros += n;
+				skip(n);
+
+				return true;
+			}
+
+			if (count == 0)
+				return false;
+
+			zeros += count;
+			skip(count);
+		}
+	}
+
+	//Skip padding to next whole byte
+	void align()
+	{
+		auto padding = static_cast<std::uint32_t>((8 - consumed() % 8) % 8);
+		ensure(padding);
+		skip(std::min(padding, count));
+	}
+
+	//Copy next size bytes to out, reader has to be aligned
+	bool readBytes(unsigned char* out, std::size_t size)
+	{
+		//Whole bytes of bit buffer go first
+		while (size > 0 && count >= 8)
+		{
+			*out++ = static_cast<unsigned char>(bits >> 56);
+			skip(8);
+			size--;
+		}
+
+		while (size > 0)
+		{
+			if (ptr == end && (finished || !source.read(ptr, end)))
+			{
+				finished = true;
+				return false;
+			}
+
+			auto bytes = std::min<std::size_t>(size, end - ptr);
+			std::memcpy(out, ptr, bytes);
+			out += bytes;
+			ptr += bytes;
+			loaded += bytes;
+			size -= bytes;
+		}
+
+		return true;
+	}
+
+	//Number of bits in buffer
+	std::uint32_t available() const
+	{
+		return count;
+	}
+
+	//Number of bits taken from buffer
+	std::uint64_t consumed() const
+	{
+		return loaded * 8 - count;
+	}
+
+private:
+	void refill()
+	{
+		while (count <= 56)
+		{
+			if (ptr == end)
+			{
+				if (finished || !source.read(ptr, end))
+				{
+					finished = true;
+					return;
+				}
+
+				continue;
+			}
+
+			if (end - ptr >= 8)
+			{
+				//Load whole word and take as many bytes as fits
+				std::uint64_t word{};
+				for (int i = 0; i < 8; i++)
+				{
+					word = (word << 8) | ptr[i];
+				}
+
+				auto bytes = (63 - count) >> 3;
+				bits |= word >> count;
+				bits &= ~0ull << (64 - count - bytes * 8);
+				ptr += bytes;
+				loaded += bytes;
+				count += bytes * 8;
+
+				return;
+			}
+
+			bits |= static_cast<std::uint64_t>(*ptr++) << (56 - count);
+			loaded++;
+			count += 8;
+		}
+	}
+
+	Source& source;
+	const unsigned char* ptr{ nullptr };
+	const unsigned char* end{ nullptr };
+	bool finished{ false };
+
+	std::uint64_t bits{};
+	std::uint32_t count{};
+	std::uint64_t loaded{};
+};
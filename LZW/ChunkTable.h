@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+#include "LittleEndian.h"
+
+//Chunked stream is sequence of independent byte aligned LZW streams with table at the end
+//Table: entries, dictionary base size, number of entries, magic; all little endian 64 bit
+struct ChunkEntry
+{
+	std::uint64_t uncompressed_size{};
+	std::uint64_t compressed_size{};
+};
+
+struct ChunkTable
+{
+	//Base size of encoder dictionary, decoder needs it for dictionary size limit
+	std::uint64_t base_size{};
+	std::vector<ChunkEntry> chunks{};
+
+	//Size of fixed part at the end of file
+	static constexpr std::size_t footer_size = 3 * 8;
+	static constexpr std::uint64_t magic = 0x4B4E554843575A4Cull;
+
+	std::vector<unsigned char> serialize() const
+	{
+		std::vector<unsigned char> data{};
+
+		for (auto& chunk : chunks)
+		{
+			LittleEndian::put(data, chunk.uncompressed_size);
+			LittleEndian::put(data, chunk.compressed_size);
+		}
+
+		LittleEndian::put(data, base_size);
+		LittleEndian::put(data, chunks.size());
+		LittleEndian::put(data, magic);
+
+		return data;
+	}
+
+	//Read footer, returns number of bytes of whole table or 0 if footer is invalid
+	static std::uint64_t tableSize(const unsigned char* footer)
+	{
+		if (LittleEndian::get(footer + 16) != magic)
+			return 0;
+
+		auto count = LittleEndian::get(footer + 8);
+		if (count > (std::numeric_limits<std::uint64_t>::max() - footer_size) / 16)
+			return 0;
+
+		return count * 16 + footer_size;
+	}
+
+	//Parse whole table
+	bool parse(const unsigned char* data, std::size_t size)
+	{
+		if (size < footer_size || tableSize(data + size - footer_size) != size)
+			return false;
+
+		auto count = (size - footer_size) / 16;
+		chunks.resize(count);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			chunks[i].uncompressed_size = LittleEndian::get(data + i * 16);
+			chunks[i].compressed_size = LittleEndian::get(data + i * 16 + 8);
+		}
+
+		base_size = LittleEndian::get(data + count * 16);
+
+		return true;
+	}
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "PresetDictionary.h"
+
+//Dictionary of decoder, phrases are only looked up by code, so it is plain array
+//Codes are given in insertion order, 1-256 are single characters, 257 is clear_code
+class DecoderDictionary
+{
+public:
+	DecoderDictionary(std::size_t max_size, const PresetDictionary* preset = nullptr) : max_size{ max_size }
+	{
+		entries.resize(1);
+
+		for (int i = 0; i <= 255; i++)
+		{
+			auto character = static_cast<unsigned char>(i);
+			entries.push_back({ 0, 1, character, character });
+		}
+
+		//clear_code is not phrase, decoder handles it before lookup
+		entries.emplace_back();
+
+		//Preset phrases get same codes as in encoder
+		for (std::size_t i = 0; preset && i < preset->size(); i++)
+		{
+			insert(preset->parent(i), preset->character(i));
+		}
+
+		initial_size = entries.size();
+	}
+
+	//Number of phrases, characters included
+	std::size_t size() const
+	{
+		return entries.size() - 1;
+	}
+
+	std::size_t maxSize() const
+	{
+		return max_size;
+	}
+
+	//Entries are never changed after insert, so initial ones stay valid
+	void clear()
+	{
+		entries.resize(initial_size);
+	}
+
+	//Code which will be given to next phrase
+	std::size_t nextCode() const
+	{
+		return entries.size();
+	}
+
+	bool contains(std::size_t code) const
+	{
+		return code != 0 && code < entries.size();
+	}
+
+	//Add phrase of code extended by character
+	void insert(std::size_t code, unsigned char character)
+	{
+		auto& parent = entries[code];
+		entries.push_back({ static_cast<std::uint32_t>(code), parent.length + 1, character, parent.first });
+	}
+
+	std::uint32_t length(std::size_t code) const
+	{
+		return entries[code].length;
+	}
+
+	unsigned char first(std::size_t code) const
+	{
+		return entries[code].first;
+	}
+
+	//Write phrase to [out, out + length(code)), phrase is known from the end
+	void copy(std::size_t code, unsigned char* out) const
+	{
+		auto ptr = out + entries[code].length;
+
+		do
+		{
+			auto& entry = entries[code];
+			*--ptr = entry.last;
+			code = entry.parent;
+		} while (ptr != out);
+	}
+
+private:
+	struct Entry
+	{
+		std::uint32_t parent{};
+		std::uint32_t length{};
+		unsigned char last{};
+		unsigned char first{};
+	};
+
+	const std::size_t max_size;
+	//Characters, clear_code and preset
+	std::size_t initial_size{};
+
+	//Entry 0 is unused, so code 0 is never valid
+	std::vector<Entry> entries{};
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <type_traits>
+
+#include "HashTable.h"
+#include "Trie.h"
+#include "GrowingHashTable.h"
+
+//Dictionary used by coder for SPEED policy, HASH is used only by fixed hash tables
+template<typename SPEED, typename HASH = DictionaryHashTableHelper::default_hash<SPEED>>
+using Dictionary = std::conditional_t<std::is_same_v<SPEED, DictionaryHashTableHelper::trie>, DictionaryTrie,
+	std::conditional_t<std::is_same_v<SPEED, DictionaryHashTableHelper::adaptive>, DictionaryGrowingTable, DictionaryHashTable<SPEED, HASH>>>;
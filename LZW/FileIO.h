@@ -0,0 +1,398 @@
+#pragma once
+
+#include <fstream>
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+enum class IOMode
+{
+	//std::fstream, input is copied to 100MB buffer
+	stream,
+	//Input is memory mapped, output is written with big pwrites
+	mapped
+};
+
+namespace FileIOHelper
+{
+	constexpr IOMode defaultMode()
+	{
+#ifdef _WIN32
+		return IOMode::stream;
+#else
+		return IOMode::mapped;
+#endif
+	}
+}
+
+class FileIO
+{
+public:
+	//Input is read from input_offset
+	//Output is cut to output_offset and written after it, 0 creates new output
+	FileIO(std::string_view input_file, std::string_view output_file, IOMode mode = FileIOHelper::defaultMode(), std::uint64_t input_offset = 0, std::uint64_t output_offset = 0);
+	FileIO(const FileIO&) = delete;
+	FileIO(FileIO&&) = delete;
+	FileIO& operator=(const FileIO&) = delete;
+	FileIO& operator=(FileIO&&) = delete;
+
+	~FileIO();
+
+	bool isValid() const { return valid; }
+
+	//Get next part of input file
+	//[begin, end) is valid until next read
+	//Returns false if there is no more data
+	bool read(const unsigned char*& begin, const unsigned char*& end);
+
+	//Get next part of input file, stream mode reads it into storage
+	//[begin, end) is valid until release
+	bool read(std::vector<unsigned char>& storage, const unsigned char*& begin, const unsigned char*& end);
+
+	//Part of input is no longer needed
+	void release(const unsigned char* begin, const unsigned char* end);
+
+	std::uint64_t inputSize();
+
+	//Copy size bytes from offset of input file to storage, doesn't change position of read
+	bool readAt(std::uint64_t offset, std::size_t size, std::vector<unsigned char>& storage);
+
+	//Size of part returned by read
+	void setPartSize(std::size_t size)
+	{
+		part_size = size;
+	}
+
+	//Returns false if output can't be written, FileIO is not valid after that
+	template <typename T>
+	bool write(std::vector<T>& data) {
+		auto success = write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(T));
+		data.clear();
+
+		return success;
+	}
+
+	bool write(const char* data, std::size_t size);
+
+	//Flush buffered output, returns false if any write failed
+	bool finish();
+
+	//Output buffer should be dumped after reaching this size
+	std::size_t outputBufferSize() const
+	{
+		return mode == IOMode::stream ? stream_buffer_size : mapped_output_size;
+	}
+
+private:
+	void openStream(std::string_view input_file, std::string_view output_file, std::uint64_t input_offset, std::uint64_t output_offset);
+	void openMapped(std::string_view input_file, std::string_view output_file, std::uint64_t input_offset, std::uint64_t output_offset);
+
+	IOMode mode;
+	bool valid{ false };
+
+	const unsigned char* last_begin{ nullptr };
+	const unsigned char* last_end{ nullptr };
+
+	std::fstream input{};
+	std::fstream output{};
+	std::vector<unsigned char> in_buffer{};
+
+	static constexpr std::size_t stream_buffer_size = 100 * 1000 * 1024;
+	std::size_t part_size{ stream_buffer_size };
+
+#ifndef _WIN32
+	int input_fd{ -1 };
+	int output_fd{ -1 };
+	unsigned char* mapping{ nullptr };
+	std::size_t mapping_size{};
+	std::size_t mapping_pos{};
+	std::uint64_t output_pos{};
+#endif
+
+	//Mapped input is given out in windows, so already used pages can be dropped
+	static constexpr std::size_t mapped_window_size = 16 * 1024 * 1024;
+	static constexpr std::size_t mapped_output_size = 8 * 1024 * 1024;
+};
+
+inline FileIO::FileIO(std::string_view input_file, std::string_view output_file, IOMode mode, std::uint64_t input_offset, std::uint64_t output_offset) : mode{ mode }
+{
+#ifdef _WIN32
+	this->mode = IOMode::stream;
+#endif
+
+	if (this->mode == IOMode::mapped)
+	{
+		part_size = mapped_window_size;
+	}
+
+	if (output_offset > 0)
+	{
+		std::error_code error{};
+		std::filesystem::resize_file(std::string{ output_file }, output_offset, error);
+
+		if (error)
+			return;
+	}
+
+	if (this->mode == IOMode::stream)
+	{
+		openStream(input_file, output_file, input_offset, output_offset);
+	}
+	else
+	{
+		openMapped(input_file, output_file, input_offset, output_offset);
+	}
+}
+
+inline FileIO::~FileIO()
+{
+	input.close();
+	output.close();
+
+#ifndef _WIN32
+	if (mapping)
+		munmap(mapping, mapping_size);
+	if (input_fd != -1)
+		close(input_fd);
+	if (output_fd != -1)
+		close(output_fd);
+#endif
+}
+
+inline void FileIO::openStream(std::string_view input_file, std::string_view output_file, std::uint64_t input_offset, std::uint64_t output_offset)
+{
+	input.open(input_file.data(), std::ios_base::in | std::ios_base::binary);
+
+	//Pipe can't seek even to 0, so only offset of append moves input
+	if (input_offset > 0)
+	{
+		input.seekg(input_offset);
+	}
+
+	if (output_offset > 0)
+	{
+		//Opening for reading too keeps existing content
+		output.open(output_file.data(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+		output.seekp(output_offset);
+	}
+	else
+	{
+		output.open(output_file.data(), std::ios_base::out | std::ios_base::binary);
+	}
+
+	valid = input && output;
+}
+
+inline void FileIO::openMapped([[maybe_unused]] std::string_view input_file, [[maybe_unused]] std::string_view output_file,
+	[[maybe_unused]] std::uint64_t input_offset, [[maybe_unused]] std::uint64_t output_offset)
+{
+#ifndef _WIN32
+	input_fd = open(input_file.data(), O_RDONLY);
+	if (input_fd == -1)
+		return;
+
+	struct stat info {};
+	if (fstat(input_fd, &info) == -1)
+		return;
+
+	//Pipe or device can't be mapped and its size is not its content, so it is read as stream
+	if (!S_ISREG(info.st_mode))
+	{
+		close(input_fd);
+		input_fd = -1;
+
+		mode = IOMode::stream;
+		part_size = stream_buffer_size;
+		openStream(input_file, output_file, input_offset, output_offset);
+
+		return;
+	}
+
+	output_fd = open(output_file.data(), output_offset > 0 ? O_WRONLY : O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (output_fd == -1)
+		return;
+
+	output_pos = output_offset;
+
+	mapping_size = static_cast<std::size_t>(info.st_size);
+
+	if (mapping_size > 0)
+	{
+		auto ptr = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, input_fd, 0);
+		if (ptr == MAP_FAILED)
+			return;
+
+		mapping = static_cast<unsigned char*>(ptr);
+		madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+	}
+
+	if (input_offset > mapping_size)
+		return;
+
+	mapping_pos = input_offset;
+	valid = true;
+#endif
+}
+
+inline bool FileIO::read(const unsigned char*& begin, const unsigned char*& end)
+{
+	release(last_begin, last_end);
+
+	auto success = read(in_buffer, begin, end);
+	last_begin = begin;
+	last_end = end;
+
+	return success;
+}
+
+inline bool FileIO::read(std::vector<unsigned char>& storage, const unsigned char*& begin, const unsigned char*& end)
+{
+	if (mode == IOMode::stream)
+	{
+		if (!input) return false;
+		storage.resize(part_size);
+		input.read(reinterpret_cast<char*>(storage.data()), storage.size());
+		if (!input)
+		{
+			storage.resize(input.gcount());
+		}
+
+		begin = storage.data();
+		end = begin + storage.size();
+
+		return begin != end;
+	}
+
+#ifndef _WIN32
+	if (mapping_pos >= mapping_size)
+		return false;
+
+	//Windows end at multiples of part size, so only first window can start inside page when reading starts at offset
+	auto size = std::min(part_size - mapping_pos % part_size, mapping_size - mapping_pos);
+	begin = mapping + mapping_pos;
+	end = begin + size;
+	mapping_pos += size;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+inline void FileIO::release([[maybe_unused]] const unsigned char* begin, [[maybe_unused]] const unsigned char* end)
+{
+#ifndef _WIN32
+	if (mode == IOMode::mapped && begin != end)
+	{
+		//Window is consumed, drop its pages, madvise needs page aligned start
+		auto page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+		auto start = reinterpret_cast<std::uintptr_t>(begin) & ~(page - 1);
+		madvise(reinterpret_cast<void*>(start), reinterpret_cast<std::uintptr_t>(end) - start, MADV_DONTNEED);
+	}
+#endif
+}
+
+inline std::uint64_t FileIO::inputSize()
+{
+	if (mode == IOMode::stream)
+	{
+		auto position = input.tellg();
+		input.seekg(0, std::ios_base::end);
+		auto size = input.tellg();
+		input.seekg(position);
+
+		return size < 0 ? 0 : static_cast<std::uint64_t>(size);
+	}
+
+#ifndef _WIN32
+	return mapping_size;
+#else
+	return 0;
+#endif
+}
+
+inline bool FileIO::readAt(std::uint64_t offset, std::size_t size, std::vector<unsigned char>& storage)
+{
+	storage.resize(size);
+
+	if (mode == IOMode::stream)
+	{
+		auto position = input.tellg();
+		input.seekg(offset);
+		input.read(reinterpret_cast<char*>(storage.data()), size);
+		auto success = static_cast<bool>(input);
+		input.clear();
+		input.seekg(position);
+
+		return success;
+	}
+
+#ifndef _WIN32
+	if (offset > mapping_size || size > mapping_size - offset)
+		return false;
+
+	std::copy(mapping + offset, mapping + offset + size, storage.data());
+	return true;
+#else
+	return false;
+#endif
+}
+
+inline bool FileIO::write(const char* data, std::size_t size)
+{
+	if (!valid)
+		return false;
+
+	if (mode == IOMode::stream)
+	{
+		output.write(data, size);
+		valid = static_cast<bool>(output);
+
+		return valid;
+	}
+
+#ifndef _WIN32
+	while (size > 0)
+	{
+		auto written = pwrite(output_fd, data, size, static_cast<off_t>(output_pos));
+
+		//Interrupted call wrote nothing, so it is simply repeated
+		if (written == -1 && errno == EINTR)
+			continue;
+
+		if (written <= 0)
+		{
+			valid = false;
+			return false;
+		}
+
+		data += written;
+		size -= written;
+		output_pos += written;
+	}
+#endif
+
+	return true;
+}
+
+inline bool FileIO::finish()
+{
+	if (valid && mode == IOMode::stream)
+	{
+		output.flush();
+		valid = static_cast<bool>(output);
+	}
+
+	return valid;
+}
@@ -0,0 +1,355 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+
+#include "HashTable.h"
+#include "Stats.h"
+#include "HugeArray.h"
+
+namespace DictionaryHashTableHelper
+{
+	//Not fixed hash table, selects DictionaryGrowingTable
+	using adaptive = std::integral_constant<int, 5>;
+}
+
+//Hash table which measures length of its probes and grows when they get long
+//Nodes are stored by code, so realID of node doesn't change when slots are moved to larger table
+//Larger table is filled in small steps, lookups check both tables until old one is moved
+class DictionaryGrowingTable
+{
+public:
+	DictionaryGrowingTable(std::size_t base_size, const PresetDictionary* preset = nullptr);
+
+	std::size_t size() const
+	{
+		return nodes.size() - 1;
+	}
+
+	std::size_t maxSize() const
+	{
+		return capacity(base_size);
+	}
+
+	//Number of phrases doesn't depend on number of slots, so decoder knows it
+	static std::size_t capacity(std::size_t base_size)
+	{
+		return base_size - 1;
+	}
+
+	void clear();
+
+	//Node can't be in dictionary already
+	std::size_t insert(const DictionaryNode& node);
+
+	//Phrases after clear_code in code order, as parent code and character
+	std::vector<std::pair<std::uint32_t, unsigned char>> phrases() const
+	{
+		std::vector<std::pair<std::uint32_t, unsigned char>> result{};
+
+		for (std::size_t code = DictionaryHashTableHelper::clear_code + 1; code < nodes.size(); code++)
+		{
+			result.push_back({ nodes[code].parent, nodes[code].character });
+		}
+
+		return result;
+	}
+
+	//Not const, lookups measure probe length
+	const DictionaryNode* at(std::size_t parent, unsigned char character);
+	const DictionaryNode* at(std::size_t realID) const
+	{
+		return &nodes[realID];
+	}
+
+	std::size_t getNodeRealID(const DictionaryNode* node) const
+	{
+		return node - nodes.data();
+	}
+
+	//RealID is insertion order, so it is the code
+	std::size_t getCode(std::size_t realID) const
+	{
+		return realID;
+	}
+
+	//Load memory which will be needed by at(parent, character)
+	void prefetch(std::size_t parent, unsigned char character) const
+	{
+		DictionaryHashTableHelper::prefetch(&current.slots[current.toIndex(hash(parent, character))]);
+	}
+
+	std::size_t getBaseNodeRealID(unsigned char x) const
+	{
+		return x + 1;
+	}
+
+	//Number of slots, it only grows
+	std::size_t slotCount() const
+	{
+		return current.mask + 1;
+	}
+
+private:
+	//Slot has copy of node, so lookup doesn't have to load node
+	//Stamp is generation in high byte and part of hash in low byte
+	struct Slot
+	{
+		std::uint32_t parent{};
+		std::uint32_t code{};
+		std::uint16_t stamp{};
+		unsigned char character{};
+	};
+
+	struct Table
+	{
+		HugeArray<Slot> slots{};
+		std::size_t mask{};
+		unsigned bits{};
+		std::size_t used{};
+
+		Table() = default;
+		Table(unsigned bits) : slots{ std::size_t{ 1 } << bits }, mask{ (std::size_t{ 1 } << bits) - 1 }, bits{ bits } {}
+
+		std::size_t toIndex(std::uint64_t val) const
+		{
+			return val >> (64 - bits);
+		}
+	};
+
+	static std::uint64_t hash(std::uint64_t parent, unsigned char character)
+	{
+		return ((parent << 8 | character) + 1) * 0x9E3779B97F4A7C15ull;
+	}
+
+	std::uint16_t toStamp(std::uint64_t val) const
+	{
+		return static_cast<std::uint16_t>(generation << 8 | static_cast<unsigned char>(val >> 24));
+	}
+
+	const DictionaryNode* find(const Table& table, std::uint64_t val, std::size_t parent, unsigned char character, std::size_t& count) const;
+	void place(Table& table, std::uint32_t code, std::uint64_t val);
+
+	//Decide from load and measured probes if table should grow
+	bool needsGrowth();
+	void grow();
+	//Move count slots of old table to current one
+	void migrate(std::size_t count);
+
+	void insertRoots();
+
+	static unsigned bitLength(std::size_t x)
+	{
+		unsigned bits{};
+
+		while (x)
+		{
+			bits++;
+			x >>= 1;
+		}
+
+		return bits;
+	}
+
+	//Table starts small, so small inputs don't pay for big one
+	static constexpr unsigned initial_bits = 12;
+	//Table grows when average lookup checks more slots than this
+	static constexpr double max_average_probes = 2.0;
+	//Probes are averaged over this many lookups
+	static constexpr std::uint64_t probe_window = 16384;
+	//Linear probing needs free slots, so table grows at this load even with short probes
+	static constexpr double max_load = 0.9;
+	static constexpr std::size_t migrate_step = 16;
+
+	const std::size_t base_size;
+	//Table with all phrases has at most half of slots used
+	const unsigned max_bits;
+	const PresetDictionary* preset;
+
+	//Node 0 is not used, 1-256 are characters, 257 is clear_code
+	std::vector<DictionaryNode> nodes{};
+
+	Table current;
+	//Table being moved to current one, empty if table doesn't grow now
+	Table old{};
+	std::size_t migrated{};
+
+	std::uint64_t probes{};
+	std::uint64_t lookups{};
+
+	//Generation 0 is never used, so zeroed slots are empty
+	std::uint16_t generation{ 1 };
+};
+
+inline DictionaryGrowingTable::DictionaryGrowingTable(std::size_t base_size, const PresetDictionary* preset) : base_size{ base_size },
+	max_bits{ std::max(initial_bits, bitLength(base_size) + 1) }, preset{ preset }, current{ initial_bits }
+{
+	insertRoots();
+}
+
+inline void DictionaryGrowingTable::insertRoots()
+{
+	nodes.clear();
+	nodes.emplace_back();
+
+	//Set up ASCII characters
+	for (int i = 0; i <= 255; i++)
+	{
+		insert({ 0, static_cast<unsigned char>(i) });
+	}
+
+	//Reserve clear_code, it has no slot
+	nodes.emplace_back();
+
+	//Code of preset phrase is its realID
+	for (std::size_t i = 0; preset && i < preset->size(); i++)
+	{
+		insert({ preset->parent(i), preset->character(i) });
+	}
+}
+
+inline void DictionaryGrowingTable::clear()
+{
+	//Nodes in old table would be dropped anyway
+	old = Table{};
+
+	//Table keeps its size, next dictionary will probably need it again
+	if (generation == 0xFF)
+	{
+		std::fill(current.slots.get(), current.slots.get() + current.mask + 1, Slot{});
+		generation = 1;
+	}
+	else
+	{
+		generation++;
+	}
+
+	current.used = 0;
+	probes = 0;
+	lookups = 0;
+
+	insertRoots();
+}
+
+inline const DictionaryNode* DictionaryGrowingTable::find(const Table& table, std::uint64_t val, std::size_t parent, unsigned char character, std::size_t& count) const
+{
+	auto stamp = toStamp(val);
+
+	//Table is never full, so there is always empty slot
+	for (auto index = table.toIndex(val);; index = (index + 1) & table.mask)
+	{
+		count++;
+
+		auto& slot = table.slots[index];
+
+		if ((slot.stamp >> 8) != generation)
+			return nullptr;
+
+		if (slot.stamp == stamp && slot.parent == parent && slot.character == character)
+			return &nodes[slot.code];
+	}
+}
+
+inline void DictionaryGrowingTable::place(Table& table, std::uint32_t code, std::uint64_t val)
+{
+	auto index = table.toIndex(val);
+
+	while ((table.slots[index].stamp >> 8) == generation)
+	{
+		index = (index + 1) & table.mask;
+	}
+
+	auto& node = nodes[code];
+	table.slots[index] = { node.parent, code, toStamp(val), node.character };
+	table.used++;
+}
+
+inline const DictionaryNode* DictionaryGrowingTable::at(std::size_t parent, unsigned char character)
+{
+	auto val = hash(parent, character);
+	std::size_t count{};
+
+	auto node = find(current, val, parent, character, count);
+
+	//Not moved part of old table
+	if (!node && old.slots)
+	{
+		node = find(old, val, parent, character, count);
+	}
+
+	LZW_STAT(Stats::local().probe(count));
+
+	probes += count;
+	lookups++;
+
+	return node;
+}
+
+inline std::size_t DictionaryGrowingTable::insert(const DictionaryNode& node)
+{
+	if (old.slots)
+	{
+		migrate(migrate_step);
+	}
+	else if (needsGrowth())
+	{
+		grow();
+	}
+
+	auto code = static_cast<std::uint32_t>(nodes.size());
+	nodes.push_back(node);
+	place(current, code, hash(node.parent, node.character));
+
+	return code;
+}
+
+inline bool DictionaryGrowingTable::needsGrowth()
+{
+	if (current.bits >= max_bits)
+		return false;
+
+	if (current.used + 1 > static_cast<std::size_t>((current.mask + 1) * max_load))
+		return true;
+
+	if (lookups < probe_window)
+		return false;
+
+	auto average = static_cast<double>(probes) / lookups;
+	probes = 0;
+	lookups = 0;
+
+	return average > max_average_probes;
+}
+
+inline void DictionaryGrowingTable::grow()
+{
+	old = std::move(current);
+	current = Table{ old.bits + 1 };
+	migrated = 0;
+}
+
+inline void DictionaryGrowingTable::migrate(std::size_t count)
+{
+	auto end = std::min(migrated + count, old.mask + 1);
+
+	for (; migrated < end; migrated++)
+	{
+		auto& slot = old.slots[migrated];
+
+		if ((slot.stamp >> 8) == generation)
+		{
+			place(current, slot.code, hash(slot.parent, slot.character));
+		}
+	}
+
+	if (migrated > old.mask)
+	{
+		//Probes measured with two tables don't describe new one
+		old = Table{};
+		probes = 0;
+		lookups = 0;
+	}
+}
@@ -3,11 +3,36 @@
 #include <cstdint>
 #include <utility>
 #include <memory>
-
+#include <limits>
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+#include <functional>
+
+#include "Stats.h"
+#include "HugeArray.h"
+#include "PresetDictionary.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define DICTIONARY_SSE2
+#endif
+
+#if defined(__SSE4_2__) || defined(__AVX__)
+#include <nmmintrin.h>
+#define DICTIONARY_CRC32
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//Node is identified by parent realID and last character
+//RealID 0 is never used, so parent == 0 means ASCII character
 struct DictionaryNode
 {
-	std::size_t index{};
-	std::size_t parent{};
+	std::uint32_t parent{};
 	unsigned char character{};
 };
 
@@ -15,13 +40,163 @@ namespace DictionaryHashTableHelper
 {
 	using slow = std::integral_constant<int, 1>;
 	using fast = std::integral_constant<int, 2>;
+	//Swiss table style, tags of whole group are compared at once
+	using swiss = std::integral_constant<int, 3>;
+
+	constexpr std::size_t group_size = 16;
+
+	//Codes 1-256 are characters, next code tells decoder to clear dictionary
+	constexpr std::uint32_t clear_code = 257;
+
+	//Bit i is set if group[i] == tag
+	inline std::uint32_t matchTags(const unsigned char* group, unsigned char tag)
+	{
+#ifdef DICTIONARY_SSE2
+		auto data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+		auto result = _mm_cmpeq_epi8(data, _mm_set1_epi8(static_cast<char>(tag)));
+		return static_cast<std::uint32_t>(_mm_movemask_epi8(result));
+#else
+		std::uint32_t mask{};
+		for (std::size_t i = 0; i < group_size; i++)
+		{
+			mask |= static_cast<std::uint32_t>(group[i] == tag) << i;
+		}
+		return mask;
+#endif
+	}
+
+	inline std::uint32_t countTrailingZeros(std::uint32_t val)
+	{
+#ifdef _MSC_VER
+		unsigned long index{};
+		_BitScanForward(&index, val);
+		return index;
+#else
+		return __builtin_ctz(val);
+#endif
+	}
+
+	inline void prefetch(const void* ptr)
+	{
+#ifdef DICTIONARY_SSE2
+		_mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(ptr);
+#endif
+	}
+
+	//Hash policies of node with parent realID and character
+	//They only decide slots of nodes, codes are given in insertion order, so output is the same with all of them
+
+	//Parent + character, neighbour parents fill neighbour slots, so probing gets long clusters
+	struct additive
+	{
+		static std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+		{
+			if (a > std::numeric_limits<std::uint64_t>::max() - 1 - b)
+			{
+				return a - (std::numeric_limits<std::uint64_t>::max() - 1 - b);
+			}
+
+			return a + b + 1;
+		}
+	};
+
+	//Boost hash_combine, std::hash of integer is identity in libstdc++ and libc++, so it mixes little
+	struct combine
+	{
+		static std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+		{
+			auto seed = std::hash<std::uint64_t>{}(a);
+
+			seed ^= std::hash<std::uint64_t>{}(b) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+			return seed;
+		}
+	};
+
+	//Multiplication by 2^64 / golden ratio, best bits are the high ones
+	//Index is taken by modulo, so they are folded to low bits
+	struct fibonacci
+	{
+		static std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+		{
+			auto val = (a << 8 | b) * 0x9E3779B97F4A7C15ull;
+			return val ^ (val >> 32);
+		}
+	};
+
+	//CRC32C of node, one instruction with SSE 4.2, table otherwise
+	struct crc32c
+	{
+		static std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+		{
+			auto key = a << 8 | b;
+
+#ifdef DICTIONARY_CRC32
+			return _mm_crc32_u64(0xFFFFFFFFull, key);
+#else
+			static const auto table = []
+			{
+				std::array<std::uint32_t, 256> result{};
+
+				for (std::uint32_t i = 0; i < 256; i++)
+				{
+					auto crc = i;
+
+					for (int j = 0; j < 8; j++)
+					{
+						crc = crc & 1 ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+					}
+
+					result[i] = crc;
+				}
+
+				return result;
+			}();
+
+			std::uint32_t crc{ 0xFFFFFFFFu };
+
+			for (int i = 0; i < 8; i++)
+			{
+				crc = table[(crc ^ (key >> (8 * i))) & 0xFF] ^ (crc >> 8);
+			}
+
+			return crc;
+#endif
+		}
+	};
+
+	//Mixing of wyhash, 128 bit product of keyed halves folded to 64 bits
+	struct wyhash
+	{
+		static std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+		{
+			a ^= 0xa0761d6478bd642full;
+			b ^= 0xe7037ed1a0b428dbull;
+
+#ifdef _MSC_VER
+			std::uint64_t high{};
+			auto low = _umul128(a, b, &high);
+			return low ^ high;
+#else
+			auto product = static_cast<unsigned __int128>(a) * b;
+			return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#endif
+		}
+	};
+
+	//Hash which SPEED uses if none is given
+	//Fibonacci is as even as crc32c and wyhash in bench-hash and needs no special instruction
+	template<typename SPEED>
+	using default_hash = std::conditional_t<std::is_same_v<SPEED, slow>, additive, fibonacci>;
 }
 
-template<typename SPEED = DictionaryHashTableHelper::slow>
+template<typename SPEED = DictionaryHashTableHelper::slow, typename HASH = DictionaryHashTableHelper::default_hash<SPEED>>
 class DictionaryHashTable
 {
 public:
-	DictionaryHashTable(std::size_t base_size);
+	//Preset phrases are added after roots on every clear, preset has to outlive dictionary
+	DictionaryHashTable(std::size_t base_size, const PresetDictionary* preset = nullptr);
 
 	std::size_t size() const
 	{
@@ -29,10 +204,20 @@ public:
 	}
 
 	std::size_t maxSize() const {
+		return capacity(base_size);
+	}
+
+	//Max size of dictionary with base_size slots, decoder needs it without table
+	static std::size_t capacity(std::size_t base_size) {
 		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::slow>)
 		{
 			return base_size - 1;
 		}
+		else if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			//Group probing stays short up to 7/8 load
+			return base_size / DictionaryHashTableHelper::group_size * DictionaryHashTableHelper::group_size / 8 * 7;
+		}
 		else
 		{
 			//Trying full whole dictionary is very slow, so leave some free space for speed
@@ -44,46 +229,58 @@ public:
 
 	std::size_t insert(const DictionaryNode& node);
 
-	const DictionaryNode* at(std::uint64_t index, std::uint64_t parent) const;
-	const DictionaryNode* at(std::size_t realID) const;
-	std::size_t getNodeRealID(const DictionaryNode& node) const;
+	//Phrases after clear_code in code order, as parent code and character
+	std::vector<std::pair<std::uint32_t, unsigned char>> phrases() const;
+
+	const DictionaryNode* at(std::size_t parent, unsigned char character) const;
+	const DictionaryNode* at(std::size_t realID) const
+	{
+		return &nodes[realID];
+	}
+
 	std::size_t getNodeRealID(const DictionaryNode* node) const
 	{
 		//RealID is just array index
-		return node - array.get();
+		return node - nodes.get();
 	}
 
-	std::size_t getBaseNodeRealID(unsigned char x)
+	//Code written to output, nodes are numbered in insertion order
+	//so decoder can find them without hashing
+	std::size_t getCode(std::size_t realID) const
 	{
-		//RealID of standard ASCII character
-		auto index = hash(0, x);
-		return getNodeRealID({ index, 0, x });
+		return codes[realID];
 	}
 
-	std::uint64_t hash(std::uint64_t a, std::uint64_t b)
+	//Load memory which will be needed by at(parent, character)
+	void prefetch(std::size_t parent, unsigned char character) const
 	{
-		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::slow>)
-		{
-			//Very compressed dictionary, but very slow
-			if (a > std::numeric_limits<std::uint64_t>::max() - 1 - b)
-			{
-				return a - (std::numeric_limits<std::uint64_t>::max() - 1 - b);
-			}
+		auto val = hash(parent, character);
 
-			return a + b + 1;
+		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			DictionaryHashTableHelper::prefetch(tags.get() + toGroup(val) * DictionaryHashTableHelper::group_size);
 		}
 		else
 		{
-			//Dictionary this hash generate better randomnes, but will not compress small files
-			//Only works in big dictionaries
-			//Best if input_size >> dictionary_size
-			auto seed = std::hash<std::uint64_t>{}(a);
-
-			seed ^= std::hash<std::uint64_t>{}(b) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-			return seed;
+			DictionaryHashTableHelper::prefetch(tags.get() + toIndex(val));
 		}
 	}
 
+	std::size_t getBaseNodeRealID(unsigned char x) const
+	{
+		//RealID of standard ASCII character
+		return roots[x];
+	}
+
+	std::uint64_t hash(std::uint64_t a, std::uint64_t b) const
+	{
+		return HASH::hash(a, b);
+	}
+
+	//Number of nodes which lookup finds after 1, 2, ... probes, last bucket has all longer ones
+	//Probes are slots, or groups after home slot in swiss table
+	std::vector<std::uint64_t> probeLengths(std::size_t max_probe) const;
+
 private:
 	std::size_t toIndex(std::uint64_t val) const
 	{
@@ -93,160 +290,403 @@ private:
 		return x == 0 ? (base_size - 1) : x;
 	}
 
+	std::size_t toGroup(std::uint64_t val) const
+	{
+		return val % groups;
+	}
+
+	static std::size_t toHome(std::uint64_t val)
+	{
+		//Preferred slot in first group, taken from other bits of fingerprint than tag
+		return ((val * 0x9E3779B97F4A7C15ull) >> 48) % DictionaryHashTableHelper::group_size;
+	}
+
+	//Linear probing tags have generation in high byte, slot is empty if generation is old
+	//Swiss table tags are compared 16 at once, so they stay 1 byte and are zeroed instead
+	using Tag = std::conditional_t<std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>, unsigned char, std::uint16_t>;
+
+	bool isEmpty(std::size_t index) const
+	{
+		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			return tags[index] == 0;
+		}
+		else
+		{
+			return (tags[index] >> 8) != generation;
+		}
+	}
+
+	Tag toStamped(unsigned char tag) const
+	{
+		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			return tag;
+		}
+		else
+		{
+			return static_cast<Tag>(generation << 8 | tag);
+		}
+	}
+
+	//Zero part of spare tags, called on every insert
+	void zeroSpare()
+	{
+		if (spare_zeroed < base_size)
+		{
+			auto count = std::min(zero_step, base_size - spare_zeroed);
+			std::fill(spare_tags.get() + spare_zeroed, spare_tags.get() + spare_zeroed + count, static_cast<Tag>(0));
+			spare_zeroed += count;
+		}
+	}
+
+	static unsigned char toTag(std::uint64_t val)
+	{
+		//Short fingerprint of hash, 0 marks empty slot
+		auto tag = static_cast<unsigned char>((val * 0x9E3779B97F4A7C15ull) >> 56);
+
+		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			//7 bit tags, used_slot can't match any of them
+			tag >>= 1;
+		}
+
+		return tag == 0 ? 1 : tag;
+	}
+
+	void insertRoots();
+
+	std::size_t insertGroups(const DictionaryNode& node);
+	const DictionaryNode* atGroups(std::size_t parent, unsigned char character) const;
+
+	//Slot 0 is never used, in swiss table it is marked with this tag
+	static constexpr unsigned char used_slot = 0x80;
+
 	const std::size_t base_size;
-	std::unique_ptr<DictionaryNode[]> array;
+	const std::size_t groups;
+
+	//Probing only reads tags, node is checked only when tag matches
+	//Tables are zeroed lazily by system, so only touched slots cost memory
+	HugeArray<Tag> tags;
+	HugeArray<DictionaryNode> nodes;
+	HugeArray<std::uint32_t> codes;
+	std::array<std::uint32_t, 256> roots{};
 	std::size_t _size{};
+
+	//Preset phrases have parent code, realID of parent is looked up here
+	const PresetDictionary* preset;
+	std::vector<std::uint32_t> preset_realIDs{};
+
+	//Generation 0 is never used, so zeroed tags are empty
+	std::uint16_t generation{ 1 };
+
+	//Swiss table switches to already zeroed spare tags on clear
+	//Old tags are zeroed in small steps by following inserts
+	HugeArray<Tag> spare_tags;
+	std::size_t spare_zeroed{};
+	static constexpr std::size_t zero_step = 64;
 };
 
-template<typename SPEED>
-DictionaryHashTable<SPEED>::DictionaryHashTable(std::size_t base_size) : base_size{ base_size }, array{ new DictionaryNode[base_size]{} }
+template<typename SPEED, typename HASH>
+DictionaryHashTable<SPEED, HASH>::DictionaryHashTable(std::size_t base_size, const PresetDictionary* preset) : base_size{ base_size }, groups{ base_size / DictionaryHashTableHelper::group_size },
+	tags{ base_size }, nodes{ base_size }, codes{ base_size }, preset{ preset }
+{
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+	{
+		spare_tags = HugeArray<Tag>{ base_size };
+		spare_zeroed = base_size;
+	}
+
+	insertRoots();
+}
+
+template<typename SPEED, typename HASH>
+void DictionaryHashTable<SPEED, HASH>::insertRoots()
 {
-	DictionaryNode node{};
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+	{
+		tags[0] = used_slot;
+	}
 
 	//Set up ASCII characters
 	for (int i = 0; i <= 255; i++)
 	{
-		node.character = static_cast<unsigned char>(i);
-		node.index = DictionaryHashTable::hash(0, i);
-
-		insert(node);
+		roots[i] = static_cast<std::uint32_t>(insert({ 0, static_cast<unsigned char>(i) }));
 	}
-}
 
-template<typename SPEED>
-void DictionaryHashTable<SPEED>::clear()
-{
-	_size = 0;
+	//Reserve clear_code, it has no node
+	_size++;
 
-	array.reset(new DictionaryNode[base_size]{});
+	if (!preset)
+		return;
 
-	DictionaryNode node{};
+	preset_realIDs.resize(preset->size());
 
-	for (int i = 0; i <= 255; i++)
+	for (std::size_t i = 0; i < preset->size(); i++)
 	{
-		node.character = static_cast<unsigned char>(i);
-		node.index = DictionaryHashTable::hash(0, i);
+		auto parent = preset->parent(i);
+		auto parent_realID = parent < PresetDictionary::first_code ? roots[parent - 1] : preset_realIDs[parent - PresetDictionary::first_code];
 
-		insert(node);
+		preset_realIDs[i] = static_cast<std::uint32_t>(insert({ parent_realID, preset->character(i) }));
 	}
 }
 
-template<typename SPEED>
-std::size_t DictionaryHashTable<SPEED>::insert(const DictionaryNode& node)
+template<typename SPEED, typename HASH>
+void DictionaryHashTable<SPEED, HASH>::clear()
 {
-	//Find first node with index == 0 and realID >= toIndex(node.index)
-	//If node already exists return it position
-	auto by_index = &array[toIndex(node.index)];
-
-	if (by_index->index == node.index && by_index->parent == node.parent)
-		return by_index - array.get();
+	_size = 0;
 
-	if (by_index->index == 0)
+	//Nodes are valid only with tag, so only tags have to be cleared
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
 	{
-		by_index->index = node.index;
-		by_index->parent = node.parent;
-		by_index->character = node.character;
-		_size++;
+		//Finish zeroing if dictionary was filled very fast
+		std::fill(spare_tags.get() + spare_zeroed, spare_tags.get() + base_size, static_cast<Tag>(0));
 
-		return by_index - array.get();
+		tags.swap(spare_tags);
+		spare_zeroed = 0;
+	}
+	else if (generation == 0xFF)
+	{
+		//Generations are used up, old stamps have to be removed
+		std::fill(tags.get(), tags.get() + base_size, static_cast<Tag>(0));
+		generation = 1;
+	}
+	else
+	{
+		//All slots of previous generation are empty now
+		generation++;
 	}
 
-	auto end = array.get() + base_size;
-	auto ptr = by_index + 1;
+	insertRoots();
+}
 
-	while (ptr != by_index)
+template<typename SPEED, typename HASH>
+std::size_t DictionaryHashTable<SPEED, HASH>::insert(const DictionaryNode& node)
+{
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
 	{
-		if (ptr == end)
-		{
-			//Connect end with begin
-			ptr = array.get() + 1;
-		}
+		return insertGroups(node);
+	}
 
-		if (ptr->index == node.index && ptr->parent == node.parent)
-			return ptr - array.get();
+	//Find first empty slot with realID >= toIndex(hash)
+	//If node already exists return it position
+	auto val = hash(node.parent, node.character);
+	auto tag = toStamped(toTag(val));
+	auto start = toIndex(val);
+	auto index = start;
 
-		if (ptr->index == 0)
+	do
+	{
+		if (isEmpty(index))
 		{
-			ptr->index = node.index;
-			ptr->parent = node.parent;
-			ptr->character = node.character;
-			_size++;
+			tags[index] = tag;
+			nodes[index] = node;
+			codes[index] = static_cast<std::uint32_t>(++_size);
 
-			return ptr - array.get();
+			return index;
 		}
 
-		ptr++;
-	}
+		if (tags[index] == tag && nodes[index].parent == node.parent && nodes[index].character == node.character)
+			return index;
+
+		//Connect end with begin
+		index = index + 1 == base_size ? 1 : index + 1;
+	} while (index != start);
 
 	return 0;
 }
 
-template<typename SPEED>
-const DictionaryNode* DictionaryHashTable<SPEED>::at(std::uint64_t index, std::uint64_t parent) const
+template<typename SPEED, typename HASH>
+std::vector<std::pair<std::uint32_t, unsigned char>> DictionaryHashTable<SPEED, HASH>::phrases() const
 {
-	//Find first node with node.index == index and node.parent = parent and realID >= toIndex(node.index)
-	auto by_index = &array[toIndex(index)];
+	std::vector<std::pair<std::uint32_t, unsigned char>> result(_size - DictionaryHashTableHelper::clear_code);
+
+	//Slot 0 is never used
+	for (std::size_t index = 1; index < base_size; index++)
+	{
+		if (isEmpty(index) || codes[index] <= DictionaryHashTableHelper::clear_code)
+			continue;
 
-	if (by_index->index == index && by_index->parent == parent)
-		return by_index;
+		auto& node = nodes[index];
+		result[codes[index] - DictionaryHashTableHelper::clear_code - 1] = { codes[node.parent], node.character };
+	}
 
-	auto end = array.get() + base_size;
-	auto ptr = by_index + 1;
+	return result;
+}
 
-	while (ptr != by_index)
+template<typename SPEED, typename HASH>
+std::vector<std::uint64_t> DictionaryHashTable<SPEED, HASH>::probeLengths(std::size_t max_probe) const
+{
+	std::vector<std::uint64_t> result(max_probe);
+
+	//Slot 0 is never used
+	for (std::size_t index = 1; index < base_size; index++)
 	{
-		if (ptr == end)
+		if (isEmpty(index))
+			continue;
+
+		auto val = hash(nodes[index].parent, nodes[index].character);
+		std::size_t probes{};
+
+		if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+		{
+			auto start = toGroup(val);
+
+			//Home slot, then groups from start to group of node
+			if (index == start * DictionaryHashTableHelper::group_size + toHome(val))
+			{
+				probes = 1;
+			}
+			else
+			{
+				probes = 2 + (index / DictionaryHashTableHelper::group_size + groups - start) % groups;
+			}
+		}
+		else
 		{
-			//Connect end with begin
-			ptr = array.get() + 1;
+			//Probing skips slot 0, so it goes around base_size - 1 slots
+			auto start = toIndex(val);
+			probes = 1 + (index >= start ? index - start : index + base_size - 1 - start);
 		}
 
-		if (ptr->index == 0)
-			return nullptr;
+		result[std::min(probes, max_probe) - 1]++;
+	}
 
-		if (ptr->index == index && ptr->parent == parent)
-			return ptr;
+	return result;
+}
 
-		ptr++;
+template<typename SPEED, typename HASH>
+const DictionaryNode* DictionaryHashTable<SPEED, HASH>::at(std::size_t parent, unsigned char character) const
+{
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+	{
+		return atGroups(parent, character);
 	}
 
+	//Find node with same parent and character, stop on first empty slot
+	auto val = hash(parent, character);
+	auto tag = toStamped(toTag(val));
+	auto start = toIndex(val);
+	auto index = start;
+	LZW_STAT(ProbeCounter probes{});
+
+	do
+	{
+		if (isEmpty(index))
+			return nullptr;
+
+		if (tags[index] == tag && nodes[index].parent == parent && nodes[index].character == character)
+			return &nodes[index];
+
+		LZW_STAT(probes.count++);
+
+		//Connect end with begin
+		index = index + 1 == base_size ? 1 : index + 1;
+	} while (index != start);
+
 	return nullptr;
 }
 
-template<typename SPEED>
-const DictionaryNode* DictionaryHashTable<SPEED>::at(size_t realID) const
+template<typename SPEED, typename HASH>
+std::size_t DictionaryHashTable<SPEED, HASH>::insertGroups(const DictionaryNode& node)
 {
-	return &array[realID];
-}
+	zeroSpare();
 
-template<typename SPEED>
-std::size_t DictionaryHashTable<SPEED>::getNodeRealID(const DictionaryNode& node) const
-{
-	//Just DictionaryHashTable<SPEED>::at, but return realID
-	auto by_index = &array[toIndex(node.index)];
+	//Check whole group for node, insert to first empty slot in first group with empty slot
+	auto val = hash(node.parent, node.character);
+	auto tag = toTag(val);
+	auto start = toGroup(val);
+	auto group = start;
+	auto home = start * DictionaryHashTableHelper::group_size + toHome(val);
 
-	if (by_index->index == node.index && by_index->parent == node.parent && by_index->character == node.character)
+	//Most nodes are in home slot, node found there doesn't wait for group scan
+	if (tags[home] == 0)
 	{
-		return by_index - array.get();
+		tags[home] = tag;
+		nodes[home] = node;
+		codes[home] = static_cast<std::uint32_t>(++_size);
+
+		return home;
 	}
 
-	auto end = array.get() + base_size;
-	auto ptr = by_index + 1;
+	if (tags[home] == tag && nodes[home].parent == node.parent && nodes[home].character == node.character)
+		return home;
 
-	while (ptr != by_index)
+	do
 	{
-		if (ptr == end)
+		auto first = group * DictionaryHashTableHelper::group_size;
+		auto matches = DictionaryHashTableHelper::matchTags(tags.get() + first, tag);
+
+		while (matches)
 		{
-			ptr = array.get() + 1;
+			auto index = first + DictionaryHashTableHelper::countTrailingZeros(matches);
+
+			if (nodes[index].parent == node.parent && nodes[index].character == node.character)
+				return index;
+
+			matches &= matches - 1;
 		}
 
-		if (ptr->index == node.index && ptr->parent == node.parent && ptr->character == node.character)
+		auto empty = DictionaryHashTableHelper::matchTags(tags.get() + first, 0);
+
+		if (empty)
 		{
-			return by_index - array.get();
+			auto index = first + DictionaryHashTableHelper::countTrailingZeros(empty);
+			tags[index] = tag;
+			nodes[index] = node;
+			codes[index] = static_cast<std::uint32_t>(++_size);
+
+			return index;
 		}
 
-		ptr++;
-	}
+		group = group + 1 == groups ? 0 : group + 1;
+	} while (group != start);
 
 	return 0;
 }
+
+template<typename SPEED, typename HASH>
+const DictionaryNode* DictionaryHashTable<SPEED, HASH>::atGroups(std::size_t parent, unsigned char character) const
+{
+	//Node can't be after group with empty slot
+	auto val = hash(parent, character);
+	auto tag = toTag(val);
+	auto start = toGroup(val);
+	auto group = start;
+	auto home = start * DictionaryHashTableHelper::group_size + toHome(val);
+	//Home slot is first probe, every group is next one
+	LZW_STAT(ProbeCounter probes{});
+
+	//RealID of node in home slot is known before tags are loaded, so lookups can overlap
+	if (tags[home] == tag && nodes[home].parent == parent && nodes[home].character == character)
+		return &nodes[home];
+
+	do
+	{
+		auto first = group * DictionaryHashTableHelper::group_size;
+		LZW_STAT(probes.count++);
+
+		//Node index depends on tags, so load nodes of group in parallel with tags
+		DictionaryHashTableHelper::prefetch(&nodes[first]);
+		DictionaryHashTableHelper::prefetch(&nodes[first + DictionaryHashTableHelper::group_size / 2]);
+
+		auto matches = DictionaryHashTableHelper::matchTags(tags.get() + first, tag);
+
+		while (matches)
+		{
+			auto index = first + DictionaryHashTableHelper::countTrailingZeros(matches);
+
+			if (nodes[index].parent == parent && nodes[index].character == character)
+				return &nodes[index];
+
+			matches &= matches - 1;
+		}
+
+		if (DictionaryHashTableHelper::matchTags(tags.get() + first, 0))
+			return nullptr;
+
+		group = group + 1 == groups ? 0 : group + 1;
+	} while (group != start);
+
+	return nullptr;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+//Zeroed array of big dictionary tables
+//Memory is mapped, so pages are zeroed by system only when they are touched
+//Big arrays use 2 MB pages: explicit if system has them reserved, transparent otherwise
+template <typename T>
+class HugeArray
+{
+	static_assert(std::is_trivially_copyable_v<T>, "Zero bytes have to be valid T");
+
+public:
+	HugeArray() = default;
+
+	HugeArray(std::size_t count) : count{ count }
+	{
+		allocate();
+	}
+
+	HugeArray(const HugeArray&) = delete;
+	HugeArray& operator=(const HugeArray&) = delete;
+
+	HugeArray(HugeArray&& other) noexcept
+	{
+		swap(other);
+	}
+
+	HugeArray& operator=(HugeArray&& other) noexcept
+	{
+		HugeArray{ std::move(other) }.swap(*this);
+		return *this;
+	}
+
+	~HugeArray()
+	{
+		release();
+	}
+
+	void swap(HugeArray& other) noexcept
+	{
+		std::swap(data, other.data);
+		std::swap(count, other.count);
+		std::swap(mapped, other.mapped);
+	}
+
+	T* get() const
+	{
+		return data;
+	}
+
+	T& operator[](std::size_t index) const
+	{
+		return data[index];
+	}
+
+	explicit operator bool() const
+	{
+		return data != nullptr;
+	}
+
+private:
+	//Smaller arrays wouldn't fill one huge page
+	static constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+	void allocate()
+	{
+		if (count == 0)
+			return;
+
+#ifndef _WIN32
+		if (count * sizeof(T) >= huge_page_size)
+		{
+			void* ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+			//Explicit huge pages exist only if administrator reserved them, mmap fails otherwise
+			ptr = mmap(nullptr, bytes(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+			if (ptr == MAP_FAILED)
+			{
+				ptr = mmap(nullptr, bytes(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+#ifdef MADV_HUGEPAGE
+				if (ptr != MAP_FAILED)
+				{
+					madvise(ptr, bytes(), MADV_HUGEPAGE);
+				}
+#endif
+			}
+
+			if (ptr != MAP_FAILED)
+			{
+				data = static_cast<T*>(ptr);
+				mapped = true;
+				return;
+			}
+		}
+#endif
+
+		data = new T[count]{};
+	}
+
+	void release()
+	{
+		if (!data)
+			return;
+
+#ifndef _WIN32
+		if (mapped)
+		{
+			munmap(data, bytes());
+			data = nullptr;
+			return;
+		}
+#endif
+
+		delete[] data;
+		data = nullptr;
+	}
+
+	std::size_t bytes() const
+	{
+		//Explicit huge pages are unmapped in whole pages
+		return (count * sizeof(T) + huge_page_size - 1) / huge_page_size * huge_page_size;
+	}
+
+	T* data{ nullptr };
+	std::size_t count{};
+	bool mapped{ false };
+};
@@ -0,0 +1,435 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "numberscoder.h"
+#include "LZWCoder.h"
+#include "Stats.h"
+
+//LZ77 stream is sequence of independent byte aligned blocks, matches never cross block
+//Block: size, number of literals, aligned literal bytes, sequences, padding to byte
+//Sequence: literal run + 1, then if block is not finished match length - min_match + 1 and offset
+//Literals are stored raw, so decoder copies them with memcpy instead of reading bits
+namespace LZ77Helper
+{
+	constexpr std::size_t block_size = 4 * 1024 * 1024;
+	constexpr std::size_t min_match = 4;
+
+	//Levels 1-9, higher level checks more earlier positions for longer match
+	//Window is whole block, so long chains miss cache on almost every step
+	constexpr unsigned max_level = 9;
+
+	struct Effort
+	{
+		//Positions checked in hash chain
+		std::uint32_t chain;
+		//Search stops at match this long
+		std::uint32_t nice_length;
+		//Positions inside match are added to chains
+		bool insert_all;
+		//Match at next position is checked if current one is shorter, 0 never checks it
+		std::uint32_t lazy_length;
+	};
+
+	constexpr Effort efforts[max_level]
+	{
+		{ 1, 16, false, 0 },
+		{ 2, 32, false, 0 },
+		{ 4, 32, true, 0 },
+		{ 8, 64, true, 0 },
+		{ 16, 64, true, 0 },
+		{ 32, 128, true, 16 },
+		{ 64, 256, true, 32 },
+		{ 128, 512, true, 64 },
+		{ 256, 1024, true, 128 }
+	};
+
+	inline std::uint32_t load32(const unsigned char* ptr)
+	{
+		std::uint32_t value{};
+		std::memcpy(&value, ptr, sizeof(value));
+		return value;
+	}
+
+	inline std::uint64_t load64(const unsigned char* ptr)
+	{
+		std::uint64_t value{};
+		std::memcpy(&value, ptr, sizeof(value));
+		return value;
+	}
+}
+
+//Greedy LZ77 encoder with hash chains, every call of code is one block
+template <typename NC>
+class LZ77Encoder
+{
+public:
+	LZ77Encoder(unsigned level) : effort{ LZ77Helper::efforts[std::clamp(level, 1u, LZ77Helper::max_level) - 1] },
+		head(std::size_t{ 1 } << hash_bits), chain(LZ77Helper::block_size) {}
+
+	//Code block of at most block_size bytes
+	void code(const unsigned char* begin, const unsigned char* end, BitWriter& out);
+
+	char fill() const
+	{
+		return numbers_coding.fill;
+	}
+
+private:
+	struct Sequence
+	{
+		std::uint32_t literals{};
+		std::uint32_t length{};
+		std::uint32_t offset{};
+	};
+
+	static constexpr unsigned hash_bits = 16;
+
+	static std::uint32_t hash(const unsigned char* ptr)
+	{
+		return (LZ77Helper::load32(ptr) * 2654435761u) >> (32 - hash_bits);
+	}
+
+	//Length of common prefix of a and b, b + length doesn't pass end
+	static std::size_t matchLength(const unsigned char* a, const unsigned char* b, const unsigned char* end)
+	{
+		auto start = b;
+
+		while (end - b >= 8 && LZ77Helper::load64(a) == LZ77Helper::load64(b))
+		{
+			a += 8;
+			b += 8;
+		}
+
+		while (b != end && *a == *b)
+		{
+			a++;
+			b++;
+		}
+
+		return b - start;
+	}
+
+	void insert(const unsigned char* begin, std::size_t pos)
+	{
+		auto& slot = head[hash(begin + pos)];
+		chain[pos] = slot;
+		slot = static_cast<std::uint32_t>(pos + 1);
+	}
+
+	//Longest match of pos in chain, pos is already inserted
+	std::size_t findMatch(const unsigned char* begin, const unsigned char* end, std::size_t pos, std::size_t& offset) const;
+
+	const LZ77Helper::Effort effort;
+	NC numbers_coding{};
+
+	//Position + 1 of last occurrence of hash, 0 is empty
+	std::vector<std::uint32_t> head;
+	//Position + 1 of previous occurrence with the same hash
+	std::vector<std::uint32_t> chain;
+
+	std::vector<unsigned char> literals{};
+	std::vector<Sequence> sequences{};
+};
+
+template <typename NC>
+std::size_t LZ77Encoder<NC>::findMatch(const unsigned char* begin, const unsigned char* end, std::size_t pos, std::size_t& offset) const
+{
+	auto current = begin + pos;
+	auto first = LZ77Helper::load32(current);
+	std::size_t best{};
+	LZW_STAT(std::size_t probes{});
+
+	auto candidate = chain[pos];
+
+	for (auto steps = effort.chain; candidate && steps; steps--)
+	{
+		auto match = begin + candidate - 1;
+		LZW_STAT(probes++);
+
+		//Hash collisions are rejected by first 4 bytes
+		if (LZ77Helper::load32(match) == first && match[best] == current[best])
+		{
+			auto length = LZ77Helper::min_match + matchLength(match + LZ77Helper::min_match, current + LZ77Helper::min_match, end);
+
+			if (length > best)
+			{
+				best = length;
+				offset = current - match;
+
+				//match[best] can't be checked after end
+				if (length >= effort.nice_length || current + length == end)
+					break;
+			}
+		}
+
+		candidate = chain[candidate - 1];
+	}
+
+	//Empty chain still costs lookup of its head
+	LZW_STAT(Stats::local().probe(std::max<std::size_t>(probes, 1)));
+
+	return best;
+}
+
+template <typename NC>
+void LZ77Encoder<NC>::code(const unsigned char* begin, const unsigned char* end, BitWriter& out)
+{
+	auto size = static_cast<std::size_t>(end - begin);
+
+	std::fill(head.begin(), head.end(), 0);
+	literals.clear();
+	sequences.clear();
+
+	std::size_t literal_start{};
+	std::size_t pos{};
+	//Fast levels skip further in data without matches
+	std::size_t misses{};
+
+	{
+		LZW_STAT(PhaseTimer timer{ Stats::parse });
+
+		//Last bytes can't start match which has whole first 4 bytes in block
+		while (size >= LZ77Helper::min_match && pos <= size - LZ77Helper::min_match)
+		{
+			insert(begin, pos);
+
+			std::size_t offset{};
+			auto length = findMatch(begin, end, pos, offset);
+
+			if (length >= LZ77Helper::min_match && length < effort.lazy_length && pos + 1 <= size - LZ77Helper::min_match)
+			{
+				//Longer match at next position is better than current one
+				insert(begin, pos + 1);
+
+				std::size_t next_offset{};
+				auto next_length = findMatch(begin, end, pos + 1, next_offset);
+
+				if (next_length > length + 1)
+				{
+					pos++;
+					length = next_length;
+					offset = next_offset;
+				}
+				else
+				{
+					//Next position is in chain already
+					if (effort.insert_all)
+					{
+						for (auto i = pos + 2; i < pos + length && i <= size - LZ77Helper::min_match; i++)
+						{
+							insert(begin, i);
+						}
+					}
+
+					sequences.push_back({ static_cast<std::uint32_t>(pos - literal_start), static_cast<std::uint32_t>(length), static_cast<std::uint32_t>(offset) });
+					literals.insert(literals.end(), begin + literal_start, begin + pos);
+
+					pos += length;
+					literal_start = pos;
+
+					continue;
+				}
+			}
+
+			if (length < LZ77Helper::min_match)
+			{
+				pos += effort.insert_all ? 1 : 1 + (misses++ >> 5);
+				continue;
+			}
+
+			misses = 0;
+
+			if (effort.insert_all)
+			{
+				for (auto i = pos + 1; i < pos + length && i <= size - LZ77Helper::min_match; i++)
+				{
+					insert(begin, i);
+				}
+			}
+
+			sequences.push_back({ static_cast<std::uint32_t>(pos - literal_start), static_cast<std::uint32_t>(length), static_cast<std::uint32_t>(offset) });
+			literals.insert(literals.end(), begin + literal_start, begin + pos);
+
+			pos += length;
+			literal_start = pos;
+		}
+	}
+
+	LZW_STAT(PhaseTimer timer{ Stats::emit });
+
+	//Last sequence has only literals
+	sequences.push_back({ static_cast<std::uint32_t>(size - literal_start), 0, 0 });
+	literals.insert(literals.end(), begin + literal_start, end);
+
+	LZWCoderHelper::setMaxCode(numbers_coding, LZ77Helper::block_size);
+	numbers_coding.encode(out, size);
+	LZWCoderHelper::setMaxCode(numbers_coding, size + 1);
+	numbers_coding.encode(out, literals.size() + 1);
+
+	helper::align(numbers_coding, out);
+	out.writeBytes(literals.data(), literals.size());
+
+	std::size_t done{};
+
+	for (auto& sequence : sequences)
+	{
+		LZWCoderHelper::setMaxCode(numbers_coding, size - done + 1);
+		numbers_coding.encode(out, sequence.literals + 1);
+		done += sequence.literals;
+
+		if (done == size)
+			break;
+
+		LZWCoderHelper::setMaxCode(numbers_coding, size - done - LZ77Helper::min_match + 1);
+		numbers_coding.encode(out, sequence.length - LZ77Helper::min_match + 1);
+		LZWCoderHelper::setMaxCode(numbers_coding, done);
+		numbers_coding.encode(out, sequence.offset);
+		done += sequence.length;
+	}
+
+	helper::align(numbers_coding, out);
+}
+
+//Decoder of LZ77 blocks, matches are copied inside output buffer
+template <typename NC>
+class LZ77Decoder
+{
+public:
+	//Decode all blocks from in, they are written to out_buffer from out_pos
+	//flush(out_pos) is called when out_pos > max_buffer_size, it has to empty out_buffer
+	//Returns false for invalid block or when flush returns false
+	template <typename Source, typename Flush>
+	bool decode(BitReader<Source>& in, std::vector<unsigned char>& out_buffer, std::size_t& out_pos, std::size_t max_buffer_size, Flush flush);
+
+private:
+	//Copies of matches are done in words, they can write this many bytes after match
+	static constexpr std::size_t slack = 16;
+
+	template <typename Source>
+	bool decodeBlock(BitReader<Source>& in, unsigned char* out, std::size_t size);
+
+	//Source can overlap destination
+	static void copyMatch(unsigned char* out, std::size_t offset, std::size_t length)
+	{
+		auto match = out - offset;
+		auto out_end = out + length;
+
+		if (offset >= 8)
+		{
+			//Words don't overlap, last one can go past length
+			while (out < out_end)
+			{
+				std::memcpy(out, match, 8);
+				out += 8;
+				match += 8;
+			}
+		}
+		else
+		{
+			while (out != out_end)
+			{
+				*out++ = *match++;
+			}
+		}
+	}
+
+	NC numbers_coding{};
+	std::vector<unsigned char> literals{};
+};
+
+template <typename NC>
+template <typename Source, typename Flush>
+bool LZ77Decoder<NC>::decode(BitReader<Source>& in, std::vector<unsigned char>& out_buffer, std::size_t& out_pos, std::size_t max_buffer_size, Flush flush)
+{
+	//Stream ends after last block
+	while (in.ensure(8))
+	{
+		LZWCoderHelper::setMaxCode(numbers_coding, LZ77Helper::block_size);
+		auto [size, valid] = numbers_coding.decode(in);
+
+		if (!valid || size == 0 || size > LZ77Helper::block_size)
+			return false;
+
+		if (out_buffer.size() < out_pos + size + slack)
+		{
+			out_buffer.resize(out_pos + size + slack);
+		}
+
+		if (!decodeBlock(in, out_buffer.data() + out_pos, size))
+			return false;
+
+		out_pos += size;
+
+		if (out_pos > max_buffer_size)
+		{
+			if (!flush(out_pos))
+				return false;
+
+			out_pos = 0;
+		}
+	}
+
+	return true;
+}
+
+template <typename NC>
+template <typename Source>
+bool LZ77Decoder<NC>::decodeBlock(BitReader<Source>& in, unsigned char* out, std::size_t size)
+{
+	LZWCoderHelper::setMaxCode(numbers_coding, size + 1);
+	auto [literal_count, valid] = numbers_coding.decode(in);
+
+	if (!valid || literal_count == 0 || literal_count > size + 1)
+		return false;
+
+	literal_count--;
+	literals.resize(literal_count);
+
+	in.align();
+
+	if (!in.readBytes(literals.data(), literal_count))
+		return false;
+
+	auto literal = literals.data();
+	auto literal_end = literal + literal_count;
+	std::size_t done{};
+
+	for (;;)
+	{
+		LZWCoderHelper::setMaxCode(numbers_coding, size - done + 1);
+		auto [run, run_valid] = numbers_coding.decode(in);
+
+		if (!run_valid || run == 0 || run - 1 > size - done || run - 1 > static_cast<std::size_t>(literal_end - literal))
+			return false;
+
+		std::memcpy(out + done, literal, run - 1);
+		literal += run - 1;
+		done += run - 1;
+
+		if (done == size)
+			break;
+
+		if (size - done < LZ77Helper::min_match)
+			return false;
+
+		LZWCoderHelper::setMaxCode(numbers_coding, size - done - LZ77Helper::min_match + 1);
+		auto [length, length_valid] = numbers_coding.decode(in);
+		LZWCoderHelper::setMaxCode(numbers_coding, done);
+		auto [offset, offset_valid] = numbers_coding.decode(in);
+
+		if (!length_valid || !offset_valid || length == 0 || length - 1 > size - done - LZ77Helper::min_match || offset == 0 || offset > done)
+			return false;
+
+		length += LZ77Helper::min_match - 1;
+		copyMatch(out + done, offset, length);
+		done += length;
+	}
+
+	in.align();
+
+	return literal == literal_end;
+}
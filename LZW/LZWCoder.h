@@ -0,0 +1,585 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include "numberscoder.h"
+#include "Dictionary.h"
+#include "DecoderDictionary.h"
+#include "ResetPolicy.h"
+#include "ChunkTable.h"
+#include "StreamSnapshot.h"
+#include "Stats.h"
+
+namespace LZWCoderHelper
+{
+	//Binary coder has to know largest code which can be written now
+	template <typename NC>
+	void setMaxCode([[maybe_unused]] NC& numbers_coding, [[maybe_unused]] std::size_t max_code)
+	{
+		if constexpr (std::is_same_v<NC, NumbersCoder<binary>>)
+		{
+			numbers_coding.setMaxValue(max_code);
+		}
+	}
+
+	//Dictionary can't get more phrases than input has bytes, so it never fills if it is big enough
+	//Then it gives the same codes as dictionary with max_base_size, decoder doesn't see difference
+	//Preset phrases are in dictionary from start, so they need space too
+	template <typename SPEED>
+	std::size_t fittingBaseSize(std::size_t max_base_size, std::uint64_t input_size, std::size_t preset_size = 0)
+	{
+		if (input_size >= max_base_size / 2)
+			return max_base_size;
+
+		//Characters, clear_code and one phrase per byte, hash tables get half of slots free
+		auto phrases = input_size + 258 + preset_size;
+
+		auto base_size = std::max<std::size_t>(2 * phrases, 4096);
+
+		while (base_size < max_base_size && Dictionary<SPEED>::capacity(base_size) < phrases)
+		{
+			base_size += base_size / 8;
+		}
+
+		return std::min(base_size, max_base_size);
+	}
+
+	//Codes found by parser, they are written together, so parse loop doesn't run number coder
+	//Batch doesn't refer to dictionary, so it could be emitted by other thread
+	template <typename NC>
+	class EmitBatch
+	{
+	public:
+		static constexpr std::size_t max_size = 1024;
+
+		bool full() const
+		{
+			return size == max_size;
+		}
+
+		//max_code is largest code which can be written now, only binary coder needs it
+		//Its width changes only at powers of 2 and clears, so batch keeps runs of codes with the same width
+		void push(std::size_t code, [[maybe_unused]] std::size_t max_code)
+		{
+			codes[size] = static_cast<std::uint32_t>(code);
+
+			if constexpr (std::is_same_v<NC, NumbersCoder<binary>>)
+			{
+				auto width = helper::bitLength(max_code);
+
+				if (runs == 0 || run_widths[runs - 1] != width)
+				{
+					run_starts[runs] = static_cast<std::uint32_t>(size);
+					run_widths[runs] = width;
+					runs++;
+				}
+			}
+
+			size++;
+		}
+
+		//Write all codes and empty batch
+		void emit(NC& numbers_coding, BitWriter& out)
+		{
+			if constexpr (std::is_same_v<NC, NumbersCoder<blockwise>>)
+			{
+				//Blockwise coder collects its own blocks
+				for (std::size_t i = 0; i < size; i++)
+				{
+					numbers_coding.encode(out, codes[i]);
+				}
+			}
+			else if constexpr (std::is_same_v<NC, NumbersCoder<binary>>)
+			{
+				//Codes are binary codewords, every run is packed with its width
+				for (std::size_t run = 0; run < runs; run++)
+				{
+					auto end = run + 1 < runs ? run_starts[run + 1] : size;
+					for (auto i = run_starts[run]; i < end; i++)
+						out.write(codes[i], run_widths[run]);
+				}
+			}
+			else
+			{
+				//Codewords and lengths of whole batch first, then they are placed by their offsets
+				//Codes have 32 bits, so every codeword fits in 64 bits
+				if constexpr (std::is_same_v<NC, NumbersCoder<E_gamma>> || std::is_same_v<NC, NumbersCoder<E_delta>>)
+				{
+					numbers_coding.codewords(codes.data(), values.data(), lengths.data(), size);
+				}
+				else
+				{
+					for (std::size_t i = 0; i < size; i++)
+					{
+						auto word = numbers_coding.codeword(codes[i]);
+						values[i] = word.low;
+						lengths[i] = word.length;
+					}
+				}
+
+				out.write(values.data(), lengths.data(), size);
+			}
+
+			clear();
+		}
+
+		void clear()
+		{
+			size = 0;
+			runs = 0;
+		}
+
+	private:
+		std::array<std::uint32_t, max_size> codes{};
+		std::array<std::uint64_t, max_size> values{};
+		std::array<std::uint32_t, max_size> lengths{};
+		std::size_t size{};
+
+		//Binary coder: first code and width of every run
+		std::array<std::uint32_t, max_size> run_starts{};
+		std::array<std::uint32_t, max_size> run_widths{};
+		std::size_t runs{};
+	};
+}
+
+//LZW encoder of one stream, input is given in parts
+//HASH changes only placement in hash table, output is the same
+template <typename NC, typename SPEED, typename HASH = DictionaryHashTableHelper::default_hash<SPEED>>
+class LZWEncoder
+{
+public:
+	//Dictionary starts with phrases of preset after every clear, decoder has to get the same preset
+	LZWEncoder(std::size_t base_size, ResetMode reset, const PresetDictionary* preset = nullptr) : DHT{ base_size, preset }, reset_policy{ reset } {}
+
+	//Seekable stream: every reset ends byte aligned segment instead of writing clear_code
+	//Segment also ends after max_size bytes of input, so random access doesn't decode too much
+	void enableSegments(std::uint64_t max_size)
+	{
+		segment_size = max_size;
+	}
+
+	//Two character phrases are found in direct table, so phrase doesn't need hashed lookup of second character
+	//Table only caches phrases of dictionary, so codes and stream are the same as without it
+	void enablePairTable()
+	{
+		pairs.assign(65536, 0);
+	}
+
+	//Code part of input, last phrase continues in next part
+	void code(const unsigned char* it, const unsigned char* in_end, BitWriter& out);
+
+	//Write last phrase and align output to byte
+	void finish(BitWriter& out);
+
+	//State before finish, whole bytes of out have to be flushed already, so only tail is left in it
+	//Options and output_size are filled by caller
+	StreamSnapshot snapshot(const BitWriter& out) const;
+
+	//Continue stream of snapshot, dictionary is built again by inserting its phrases in code order
+	//Returns false if they don't get the same codes, e.g. with other preset
+	bool resume(const StreamSnapshot& snapshot, BitWriter& out);
+
+	//Start new stream, which can be decoded without previous one
+	void restart()
+	{
+		clear();
+		reset_policy.restart();
+		batch.clear();
+		last_realID = 0;
+		pair_first = -1;
+		loaded = 0;
+		segments.clear();
+		segment_input = 0;
+		segment_output = 0;
+		LZW_STAT(phrase_start = 0);
+	}
+
+	//Segments finished so far, last one is finished by finish
+	const std::vector<ChunkEntry>& getSegments() const
+	{
+		return segments;
+	}
+
+	char fill() const
+	{
+		return numbers_coding.fill;
+	}
+
+	const Dictionary<SPEED, HASH>& getDictionary() const
+	{
+		return DHT;
+	}
+
+private:
+	NC numbers_coding{};
+
+	//Dictionary
+	Dictionary<SPEED, HASH> DHT;
+	ResetPolicy reset_policy;
+
+	//real index in dictionary
+	std::size_t last_realID = 0;
+
+	//Codes which are not in output yet, it is emitted when full and at the end of every part
+	LZWCoderHelper::EmitBatch<NC> batch{};
+
+	void emit(BitWriter& out)
+	{
+		LZW_STAT(PhaseTimer timer{ Stats::emit });
+		batch.emit(numbers_coding, out);
+	}
+
+	std::uint64_t loaded{};
+
+	//Align output and start new segment, which can be decoded without previous ones
+	void endSegment(BitWriter& out);
+
+	//RealID + 1 of phrase of two characters, 0 if it wasn't found yet, empty if table is disabled
+	std::vector<std::uint32_t> pairs{};
+	//First character of phrase while it has only one, -1 otherwise
+	int pair_first = -1;
+
+	//Clear dictionary and pairs of its realIDs
+	void clear()
+	{
+		DHT.clear();
+		std::fill(pairs.begin(), pairs.end(), 0);
+	}
+
+	//0 means single stream with clear_code
+	std::uint64_t segment_size{};
+	std::vector<ChunkEntry> segments{};
+	std::uint64_t segment_input{};
+	std::uint64_t segment_output{};
+
+	LZW_STAT(std::uint64_t phrase_start{};)
+};
+
+template <typename NC, typename SPEED, typename HASH>
+void LZWEncoder<NC, SPEED, HASH>::code(const unsigned char* it, const unsigned char* in_end, BitWriter& out)
+{
+	const DictionaryNode* node;
+
+	//Parse time is time of whole part without emit
+	LZW_STAT(auto start = std::chrono::steady_clock::now());
+	LZW_STAT(auto emit_start = Stats::local().time(Stats::emit));
+
+	for (; it != in_end; it++)
+	{
+		//Second character of phrase, pair table is checked before dictionary
+		std::uint32_t* pair{ nullptr };
+
+		if (pair_first >= 0)
+		{
+			pair = &pairs[pair_first << 8 | *it];
+			pair_first = -1;
+		}
+
+		if (pair && *pair)
+		{
+			last_realID = *pair - 1;
+		}
+		else if ((node = DHT.at(last_realID, *it)))
+		{
+			//Node exists, continue
+
+			last_realID = DHT.getNodeRealID(node);
+
+			if (pair)
+			{
+				*pair = static_cast<std::uint32_t>(last_realID + 1);
+			}
+		}
+		else
+		{
+			//Node don't exist, output code of last_realID
+			//and add new node
+			LZW_STAT(Stats::local().phrase(loaded - phrase_start));
+			LZW_STAT(phrase_start = loaded);
+
+			batch.push(DHT.getCode(last_realID), DHT.size());
+
+			if (batch.full())
+			{
+				emit(out);
+			}
+
+			//Full dictionary is frozen
+			if (DHT.size() < DHT.maxSize())
+			{
+				auto realID = DHT.insert({ static_cast<std::uint32_t>(last_realID), *it });
+
+				if (pair)
+				{
+					*pair = static_cast<std::uint32_t>(realID + 1);
+				}
+			}
+
+			//Policy which measures output gets all bits written so far
+			if (reset_policy.needsOutput())
+			{
+				emit(out);
+			}
+
+			if (reset_policy.update(loaded, out.written(), DHT.size() >= DHT.maxSize()))
+			{
+				LZW_STAT(Stats::local().reset(loaded, DHT.size(), DHT.maxSize()));
+
+				if (segment_size)
+				{
+					endSegment(out);
+				}
+				else
+				{
+					//Clear current dictionary for new data, decoder clears it on clear_code
+					batch.push(DictionaryHashTableHelper::clear_code, DHT.size());
+
+					if (batch.full())
+					{
+						emit(out);
+					}
+				}
+
+				clear();
+			}
+			else if (segment_size && loaded - segment_input >= segment_size)
+			{
+				LZW_STAT(Stats::local().reset(loaded, DHT.size(), DHT.maxSize()));
+				endSegment(out);
+				clear();
+				reset_policy.restart();
+			}
+
+			//Initialize new string with base character (ASCII: 0-255)
+			last_realID = DHT.getBaseNodeRealID(*it);
+
+			if (!pairs.empty())
+			{
+				pair_first = *it;
+			}
+		}
+
+		//Pair table stays in cache, dictionary is loaded only for longer phrases
+		if (it + 1 != in_end && pair_first < 0)
+		{
+			//Next lookup is known now, so start loading it
+			DHT.prefetch(last_realID, it[1]);
+		}
+
+		loaded++;
+	}
+
+	//Whole part is in output, so caller can flush it or take snapshot
+	emit(out);
+
+	LZW_STAT(Stats::local().time(Stats::parse, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - (Stats::local().time(Stats::emit) - emit_start)));
+}
+
+template <typename NC, typename SPEED, typename HASH>
+void LZWEncoder<NC, SPEED, HASH>::finish(BitWriter& out)
+{
+	if (loaded > 0)
+	{
+		LZW_STAT(Stats::local().phrase(loaded - phrase_start));
+
+		LZWCoderHelper::setMaxCode(numbers_coding, DHT.size());
+		numbers_coding.encode(out, DHT.getCode(last_realID));
+	}
+
+	if (segment_size && loaded > segment_input)
+	{
+		endSegment(out);
+	}
+	else
+	{
+		//Align to 8 bit
+		helper::align(numbers_coding, out);
+	}
+}
+
+template <typename NC, typename SPEED, typename HASH>
+StreamSnapshot LZWEncoder<NC, SPEED, HASH>::snapshot(const BitWriter& out) const
+{
+	StreamSnapshot result{};
+
+	result.input_size = loaded;
+	result.output_bits = out.written();
+	result.tail_bits = out.tailBits();
+	result.tail_length = out.tailLength();
+	result.last_code = loaded > 0 ? DHT.getCode(last_realID) : 0;
+	result.reset_state = reset_policy.getState();
+	result.phrases = DHT.phrases();
+
+	return result;
+}
+
+template <typename NC, typename SPEED, typename HASH>
+bool LZWEncoder<NC, SPEED, HASH>::resume(const StreamSnapshot& snapshot, BitWriter& out)
+{
+	restart();
+
+	//RealIDs of codes, roots and preset are in dictionary after clear already
+	std::vector<std::size_t> realIDs(DictionaryHashTableHelper::clear_code + 1 + snapshot.phrases.size());
+
+	for (int i = 0; i <= 255; i++)
+	{
+		realIDs[i + 1] = DHT.getBaseNodeRealID(static_cast<unsigned char>(i));
+	}
+
+	for (std::size_t i = 0; i < snapshot.phrases.size(); i++)
+	{
+		auto [parent, character] = snapshot.phrases[i];
+		auto code = DictionaryHashTableHelper::clear_code + 1 + i;
+
+		if (parent == 0 || parent == DictionaryHashTableHelper::clear_code || parent >= code || DHT.size() >= DHT.maxSize())
+			return false;
+
+		if (auto node = DHT.at(realIDs[parent], character))
+		{
+			realIDs[code] = DHT.getNodeRealID(node);
+		}
+		else
+		{
+			realIDs[code] = DHT.insert({ static_cast<std::uint32_t>(realIDs[parent]), character });
+		}
+
+		if (DHT.getCode(realIDs[code]) != code)
+			return false;
+	}
+
+	//Preset phrases which were not in snapshot
+	if (DHT.size() != DictionaryHashTableHelper::clear_code + snapshot.phrases.size())
+		return false;
+
+	if (snapshot.last_code >= realIDs.size() || snapshot.last_code == DictionaryHashTableHelper::clear_code || (snapshot.last_code == 0) != (snapshot.input_size == 0))
+		return false;
+
+	last_realID = snapshot.last_code ? realIDs[snapshot.last_code] : 0;
+	loaded = snapshot.input_size;
+	reset_policy.setState(snapshot.reset_state);
+	out.resume(snapshot.output_bits, snapshot.tail_bits, snapshot.tail_length);
+	LZW_STAT(phrase_start = loaded);
+
+	return true;
+}
+
+template <typename NC, typename SPEED, typename HASH>
+void LZWEncoder<NC, SPEED, HASH>::endSegment(BitWriter& out)
+{
+	emit(out);
+	helper::align(numbers_coding, out);
+
+	auto output = out.written() / 8;
+	segments.push_back({ loaded - segment_input, output - segment_output });
+
+	//Current character starts next segment
+	segment_input = loaded;
+	segment_output = output;
+}
+
+//LZW decoder of one stream
+template <typename NC>
+class LZWDecoder
+{
+public:
+	LZWDecoder(std::size_t max_size, const PresetDictionary* preset = nullptr) : dictionary{ max_size, preset } {}
+
+	//Decode all codes from in, phrases are written to out_buffer from out_pos
+	//flush(out_pos) is called when out_pos > max_buffer_size, it has to empty out_buffer
+	//Returns false for invalid code or when flush returns false
+	template <typename Source, typename Flush>
+	bool decode(BitReader<Source>& in, std::vector<unsigned char>& out_buffer, std::size_t& out_pos, std::size_t max_buffer_size, Flush flush);
+
+	//Start new stream
+	void restart()
+	{
+		dictionary.clear();
+		last_code = 0;
+	}
+
+private:
+	NC numbers_coding{};
+
+	//Decoder finds phrases only by code, so it doesn't need hash table
+	DecoderDictionary dictionary;
+
+	std::size_t last_code = 0;
+};
+
+template <typename NC>
+template <typename Source, typename Flush>
+bool LZWDecoder<NC>::decode(BitReader<Source>& in, std::vector<unsigned char>& out_buffer, std::size_t& out_pos, std::size_t max_buffer_size, Flush flush)
+{
+	while (true)
+	{
+		//Encoder has already added phrase which decoder adds after reading this code
+		auto pending = last_code != 0 && dictionary.size() < dictionary.maxSize();
+		LZWCoderHelper::setMaxCode(numbers_coding, dictionary.size() + (pending ? 1 : 0));
+
+		//new code to save
+		auto next = numbers_coding.decode(in);
+
+		if (!next.second)
+		{
+			//Number encoder returned false, so there aren't any numbers in buffer
+			return true;
+		}
+
+		auto next_code = next.first;
+
+		if (next_code == DictionaryHashTableHelper::clear_code)
+		{
+			//Next code starts new dictionary, so nothing is connected to last string
+			dictionary.clear();
+			last_code = 0;
+
+			continue;
+		}
+
+		if (pending)
+		{
+			//Connect last string, with first character from next string
+			//Full dictionary is frozen
+			if (next_code == dictionary.nextCode())
+			{
+				//Unknown code must be last string extended by its first character
+				dictionary.insert(last_code, dictionary.first(last_code));
+			}
+			else if (dictionary.contains(next_code))
+			{
+				dictionary.insert(last_code, dictionary.first(next_code));
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (!dictionary.contains(next_code))
+		{
+			return false;
+		}
+
+		auto length = dictionary.length(next_code);
+
+		if (out_pos + length > out_buffer.size())
+		{
+			out_buffer.resize(std::max<std::size_t>({ out_pos + length, out_buffer.size() * 2, 4096 }));
+		}
+
+		dictionary.copy(next_code, out_buffer.data() + out_pos);
+		out_pos += length;
+
+		if (out_pos > max_buffer_size)
+		{
+			if (!flush(out_pos))
+				return false;
+
+			out_pos = 0;
+		}
+
+		last_code = next_code;
+	}
+}
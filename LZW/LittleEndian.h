@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//Integers in files are little endian on every host
+namespace LittleEndian
+{
+	//Append lowest bytes of value
+	inline void put(std::vector<unsigned char>& data, std::uint64_t value, int bytes = 8)
+	{
+		for (int i = 0; i < bytes; i++)
+		{
+			data.push_back(static_cast<unsigned char>(value >> (8 * i)));
+		}
+	}
+
+	inline std::uint64_t get(const unsigned char* data, int bytes = 8)
+	{
+		std::uint64_t value{};
+
+		for (int i = bytes - 1; i >= 0; i--)
+		{
+			value = (value << 8) | data[i];
+		}
+
+		return value;
+	}
+}
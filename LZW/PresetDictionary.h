@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <iterator>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "LittleEndian.h"
+
+//Trained phrases, dictionary gets them after characters and clear_code, so their codes start at 258
+//File: magic, number of phrases, 4 byte parent code of every phrase, then 1 byte character of every phrase; all little endian
+//Parents and characters are separate arrays, so parents stay aligned and characters take one byte
+//Phrase can only have parent with smaller code
+//File is mapped read only, so all dictionaries of process share one copy
+class PresetDictionary
+{
+public:
+	PresetDictionary(const PresetDictionary&) = delete;
+	PresetDictionary& operator=(const PresetDictionary&) = delete;
+
+	~PresetDictionary();
+
+	//Returns nullptr if file is missing or invalid
+	static std::unique_ptr<PresetDictionary> load(const std::string& path);
+
+	//Phrases are given as parent code and character
+	static bool save(const std::string& path, const std::vector<std::pair<std::uint32_t, unsigned char>>& phrases);
+
+	std::size_t size() const
+	{
+		return count;
+	}
+
+	//Code of first phrase
+	static constexpr std::uint32_t first_code = 258;
+
+	std::uint32_t parent(std::size_t index) const
+	{
+		return parents[index];
+	}
+
+	unsigned char character(std::size_t index) const
+	{
+		return characters[index];
+	}
+
+private:
+	PresetDictionary() = default;
+
+	//Read header and check phrases
+	bool parse();
+
+	static constexpr std::uint64_t magic = 0x5445534552505A4Cull;
+	static constexpr std::size_t header_size = 16;
+	static constexpr std::size_t phrase_size = sizeof(std::uint32_t) + 1;
+
+	const std::uint32_t* parents{ nullptr };
+	const unsigned char* characters{ nullptr };
+	std::size_t count{};
+
+	//Mapped file or copy of it
+	const unsigned char* data{ nullptr };
+	std::size_t data_size{};
+	std::vector<unsigned char> storage{};
+};
+
+inline PresetDictionary::~PresetDictionary()
+{
+#ifndef _WIN32
+	if (storage.empty() && data)
+	{
+		munmap(const_cast<unsigned char*>(data), data_size);
+	}
+#endif
+}
+
+inline std::unique_ptr<PresetDictionary> PresetDictionary::load(const std::string& path)
+{
+	std::unique_ptr<PresetDictionary> preset{ new PresetDictionary{} };
+
+#ifndef _WIN32
+	auto fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return nullptr;
+
+	struct stat info {};
+	if (fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(header_size))
+	{
+		auto ptr = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+		if (ptr != MAP_FAILED)
+		{
+			preset->data = static_cast<const unsigned char*>(ptr);
+			preset->data_size = info.st_size;
+		}
+	}
+
+	close(fd);
+#else
+	std::ifstream file{ path, std::ios_base::binary };
+	preset->storage.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+	preset->data = preset->storage.data();
+	preset->data_size = preset->storage.size();
+#endif
+
+	if (!preset->data || !preset->parse())
+		return nullptr;
+
+	return preset;
+}
+
+inline bool PresetDictionary::parse()
+{
+	if (data_size < header_size)
+		return false;
+
+	if (LittleEndian::get(data) != magic || LittleEndian::get(data + 8) != (data_size - header_size) / phrase_size || (data_size - header_size) % phrase_size != 0)
+		return false;
+
+	//Parents are read directly from file, so host has to be little endian
+	const std::uint16_t probe = 1;
+	if (*reinterpret_cast<const unsigned char*>(&probe) != 1)
+		return false;
+
+	count = LittleEndian::get(data + 8);
+	parents = reinterpret_cast<const std::uint32_t*>(data + header_size);
+	characters = data + header_size + count * sizeof(std::uint32_t);
+
+	//Same phrase twice would get two codes in decoder but only one in encoder
+	std::unordered_set<std::uint64_t> phrases{};
+	phrases.reserve(count);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		//Parent is character or earlier phrase, never clear_code
+		if (parent(i) == 0 || parent(i) == first_code - 1 || parent(i) >= first_code + i)
+			return false;
+
+		if (!phrases.insert(std::uint64_t{ parent(i) } << 8 | character(i)).second)
+			return false;
+	}
+
+	return true;
+}
+
+inline bool PresetDictionary::save(const std::string& path, const std::vector<std::pair<std::uint32_t, unsigned char>>& phrases)
+{
+	std::vector<unsigned char> data{};
+
+	LittleEndian::put(data, magic);
+	LittleEndian::put(data, phrases.size());
+
+	for (auto& phrase : phrases)
+	{
+		LittleEndian::put(data, phrase.first, sizeof(std::uint32_t));
+	}
+
+	for (auto& phrase : phrases)
+	{
+		data.push_back(phrase.second);
+	}
+
+	std::ofstream file{ path, std::ios_base::binary };
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+	return static_cast<bool>(file);
+}
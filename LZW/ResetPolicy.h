@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+enum class ResetMode
+{
+	//Dictionary is cleared as soon as it is full
+	full,
+	//Full dictionary is frozen while compression ratio holds
+	//Dictionary is cleared early when ratio drops
+	adaptive
+};
+
+//Decides when encoder sends clear_code, like CLEAR in Unix compress
+//Full dictionary is always frozen, so decoder only has to follow clear_code
+class ResetPolicy
+{
+public:
+	ResetPolicy(ResetMode mode) : mode{ mode } {}
+
+	//Statistics of current window and dictionary, they are saved in snapshot of stream
+	struct State
+	{
+		std::uint32_t codes{};
+		std::uint64_t window_input{};
+		std::uint64_t window_output{};
+
+		std::uint64_t windows{};
+		double smoothed{};
+		double best{};
+	};
+
+	//Forget statistics of previous stream
+	void restart()
+	{
+		state = State{};
+	}
+
+	const State& getState() const
+	{
+		return state;
+	}
+
+	void setState(const State& saved)
+	{
+		state = saved;
+	}
+
+	//Output size is read only at the end of window, coder which delays output has to write it before that update
+	bool needsOutput() const
+	{
+		return mode == ResetMode::adaptive && state.codes + 1 >= window_size;
+	}
+
+	//Called after every emitted code, input_bytes and output_bits are totals of whole coding
+	//Returns true if dictionary should be cleared
+	bool update(std::uint64_t input_bytes, std::uint64_t output_bits, bool full)
+	{
+		if (mode == ResetMode::full)
+			return full;
+
+		if (++state.codes < window_size)
+			return false;
+
+		//Input bits per output bit in last window
+		auto ratio = 8.0 * (input_bytes - state.window_input) / static_cast<double>(std::max<std::uint64_t>(output_bits - state.window_output, 1));
+
+		state.codes = 0;
+		state.window_input = input_bytes;
+		state.window_output = output_bits;
+
+		//Single windows are noisy, so compare smoothed ratio
+		state.smoothed = state.windows == 0 ? ratio : state.smoothed + (ratio - state.smoothed) / 4;
+		state.windows++;
+
+		//New dictionary needs some time to learn data
+		if (state.windows <= warm_up_windows)
+			return false;
+
+		state.best = std::max(state.best, state.smoothed);
+
+		//Frozen dictionary only gets older, so it is kept only while ratio is close to best
+		if (state.smoothed < state.best * (full ? frozen_drop_factor : drop_factor))
+		{
+			state.windows = 0;
+			state.best = 0;
+
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	const ResetMode mode;
+
+	//Number of codes in window
+	static constexpr std::uint32_t window_size = 4096;
+	static constexpr std::uint32_t warm_up_windows = 8;
+	//Dictionary is cleared when ratio falls under this part of best ratio
+	static constexpr double drop_factor = 0.7;
+	static constexpr double frozen_drop_factor = 0.98;
+
+	State state{};
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+//Instrumentation of coding, it exists only when LZW_STATS is defined
+//LZW_STAT(statement) disappears from hot loops otherwise
+#ifdef LZW_STATS
+#define LZW_STAT(...) __VA_ARGS__
+#else
+#define LZW_STAT(...)
+#endif
+
+#ifdef LZW_STATS
+
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+class Stats
+{
+public:
+	enum Phase
+	{
+		read,
+		parse,
+		emit,
+		write,
+		phases
+	};
+
+	//Statistics of current thread
+	static Stats& local()
+	{
+		thread_local Stats stats{};
+		return stats;
+	}
+
+	//Add statistics of current thread to total, called when thread finishes coding
+	static void flush()
+	{
+		std::lock_guard lock{ mutex };
+		total().add(local());
+		local() = Stats{};
+	}
+
+	static Stats& total()
+	{
+		static Stats stats{};
+		return stats;
+	}
+
+	void time(Phase phase, double seconds)
+	{
+		times[phase] += seconds;
+	}
+
+	double time(Phase phase) const
+	{
+		return times[phase];
+	}
+
+	//Number of slots, groups or siblings checked by one lookup, at least 1
+	void probe(std::size_t length)
+	{
+		probe_lengths[std::min<std::size_t>(length, max_probe) - 1]++;
+	}
+
+	//Phrases are counted in power of 2 buckets
+	void phrase(std::uint64_t length)
+	{
+		std::size_t bucket{};
+
+		while (length >>= 1)
+		{
+			bucket++;
+		}
+
+		phrase_lengths[bucket]++;
+	}
+
+	void reset(std::uint64_t input, std::size_t size, std::size_t max_size)
+	{
+		resets.push_back({ input, size, max_size });
+	}
+
+	void writeJSON(std::ostream& out) const;
+
+private:
+	static inline std::mutex mutex{};
+
+	static constexpr std::size_t max_probe = 64;
+
+	struct Reset
+	{
+		std::uint64_t input{};
+		std::size_t size{};
+		std::size_t max_size{};
+	};
+
+	std::array<double, phases> times{};
+	//Bucket i has lookups with i + 1 probes, last bucket has all longer probes
+	std::array<std::uint64_t, max_probe> probe_lengths{};
+	//Bucket i has lengths [2^i, 2^(i+1))
+	std::array<std::uint64_t, 64> phrase_lengths{};
+	std::vector<Reset> resets{};
+
+	void add(const Stats& other)
+	{
+		for (std::size_t i = 0; i < phases; i++)
+		{
+			times[i] += other.times[i];
+		}
+
+		for (std::size_t i = 0; i < probe_lengths.size(); i++)
+		{
+			probe_lengths[i] += other.probe_lengths[i];
+		}
+
+		for (std::size_t i = 0; i < phrase_lengths.size(); i++)
+		{
+			phrase_lengths[i] += other.phrase_lengths[i];
+		}
+
+		resets.insert(resets.end(), other.resets.begin(), other.resets.end());
+	}
+};
+
+inline void Stats::writeJSON(std::ostream& out) const
+{
+	const char* names[phases]{ "read", "parse", "emit", "write" };
+
+	out << "{\n\t\"time\": {";
+
+	for (std::size_t i = 0; i < phases; i++)
+	{
+		out << (i ? ", " : " ") << "\"" << names[i] << "\": " << times[i];
+	}
+
+	out << " },\n\t\"probe_length\": [";
+
+	for (std::size_t i = 0; i < probe_lengths.size(); i++)
+	{
+		out << (i ? ", " : "") << probe_lengths[i];
+	}
+
+	out << "],\n\t\"phrase_length_log2\": [";
+
+	for (std::size_t i = 0; i < phrase_lengths.size(); i++)
+	{
+		out << (i ? ", " : "") << phrase_lengths[i];
+	}
+
+	out << "],\n\t\"resets\": [";
+
+	for (std::size_t i = 0; i < resets.size(); i++)
+	{
+		out << (i ? "," : "") << "\n\t\t{ \"input\": " << resets[i].input << ", \"size\": " << resets[i].size
+			<< ", \"fill\": " << static_cast<double>(resets[i].size) / resets[i].max_size << " }";
+	}
+
+	out << (resets.empty() ? "" : "\n\t") << "]\n}\n";
+}
+
+//Adds time from construction to destruction to phase
+class PhaseTimer
+{
+public:
+	PhaseTimer(Stats::Phase phase) : phase{ phase } {}
+
+	~PhaseTimer()
+	{
+		Stats::local().time(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+
+private:
+	Stats::Phase phase;
+	std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+};
+
+//Counts probes of one lookup
+struct ProbeCounter
+{
+	std::size_t count{ 1 };
+
+	~ProbeCounter()
+	{
+		Stats::local().probe(count);
+	}
+};
+
+#endif
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+#include "ResetPolicy.h"
+#include "LittleEndian.h"
+
+//State of encoder before last phrase of stream was written, coding of appended input continues from it
+//Stream in file ends with output_size whole bytes, bits after them are in tail and are written again
+//File: fixed fields, phrases of dictionary as parent code and character, magic; all little endian 64 bit
+struct StreamSnapshot
+{
+	//Options which give the same codes, appending with other ones would break stream
+	std::uint64_t dictionary{};
+	std::uint64_t base_size{};
+	std::uint64_t preset_size{};
+	std::uint64_t reset_mode{};
+
+	//Coded input and whole bytes of output
+	std::uint64_t input_size{};
+	std::uint64_t output_size{};
+
+	//Bits written to stream, tail_length of them are not in output_size bytes
+	std::uint64_t output_bits{};
+	std::uint64_t tail_bits{};
+	std::uint64_t tail_length{};
+
+	//Code of phrase which is not finished yet, 0 if input was empty
+	std::uint64_t last_code{};
+	ResetPolicy::State reset_state{};
+
+	//Phrases after clear_code, preset included
+	std::vector<std::pair<std::uint32_t, unsigned char>> phrases{};
+
+	static constexpr std::uint64_t magic = 0x50414E5357535A4Cull;
+
+	std::vector<unsigned char> serialize() const
+	{
+		std::vector<unsigned char> data{};
+
+		for (auto value : { dictionary, base_size, preset_size, reset_mode, input_size, output_size, output_bits, tail_bits, tail_length, last_code })
+		{
+			LittleEndian::put(data, value);
+		}
+
+		LittleEndian::put(data, reset_state.codes);
+		LittleEndian::put(data, reset_state.window_input);
+		LittleEndian::put(data, reset_state.window_output);
+		LittleEndian::put(data, reset_state.windows);
+		LittleEndian::put(data, toBits(reset_state.smoothed));
+		LittleEndian::put(data, toBits(reset_state.best));
+
+		LittleEndian::put(data, phrases.size());
+
+		for (auto& [parent, character] : phrases)
+		{
+			LittleEndian::put(data, std::uint64_t{ parent } << 8 | character);
+		}
+
+		LittleEndian::put(data, magic);
+
+		return data;
+	}
+
+	bool parse(const unsigned char* data, std::size_t size)
+	{
+		if (size < fields * 8 || LittleEndian::get(data + size - 8) != magic)
+			return false;
+
+		auto count = LittleEndian::get(data + (fields - 2) * 8);
+		if (count != (size - fields * 8) / 8 || (size - fields * 8) % 8 != 0)
+			return false;
+
+		for (auto value : { &dictionary, &base_size, &preset_size, &reset_mode, &input_size, &output_size, &output_bits, &tail_bits, &tail_length, &last_code })
+		{
+			*value = LittleEndian::get(data);
+			data += 8;
+		}
+
+		reset_state.codes = static_cast<std::uint32_t>(LittleEndian::get(data));
+		reset_state.window_input = LittleEndian::get(data + 8);
+		reset_state.window_output = LittleEndian::get(data + 16);
+		reset_state.windows = LittleEndian::get(data + 24);
+		reset_state.smoothed = fromBits(LittleEndian::get(data + 32));
+		reset_state.best = fromBits(LittleEndian::get(data + 40));
+		data += 56;
+
+		phrases.resize(count);
+
+		for (auto& [parent, character] : phrases)
+		{
+			auto value = LittleEndian::get(data);
+			parent = static_cast<std::uint32_t>(value >> 8);
+			character = static_cast<unsigned char>(value);
+			data += 8;
+		}
+
+		return tail_length < 32 && output_bits == output_size * 8 + tail_length;
+	}
+
+private:
+	//Fixed fields, reset state, number of phrases and magic
+	static constexpr std::size_t fields = 10 + 6 + 1 + 1;
+
+	static std::uint64_t toBits(double value)
+	{
+		std::uint64_t bits{};
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static double fromBits(std::uint64_t bits)
+	{
+		double value{};
+		std::memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <type_traits>
+
+#include "HashTable.h"
+#include "Stats.h"
+
+namespace DictionaryHashTableHelper
+{
+	//Not hash table, selects DictionaryTrie
+	using trie = std::integral_constant<int, 4>;
+}
+
+//Trie dictionary, realID is insertion order of node
+//Children are kept in sibling list, nodes with many children get dense 256 way table
+class DictionaryTrie
+{
+public:
+	DictionaryTrie(std::size_t base_size, const PresetDictionary* preset = nullptr);
+
+	std::size_t size() const
+	{
+		return nodes.size() - 1;
+	}
+
+	std::size_t maxSize() const
+	{
+		return capacity(base_size);
+	}
+
+	static std::size_t capacity(std::size_t base_size)
+	{
+		return base_size - 1;
+	}
+
+	void clear();
+
+	std::size_t insert(const DictionaryNode& node);
+
+	//Phrases after clear_code in code order, as parent code and character
+	std::vector<std::pair<std::uint32_t, unsigned char>> phrases() const
+	{
+		std::vector<std::pair<std::uint32_t, unsigned char>> result{};
+
+		for (std::size_t code = DictionaryHashTableHelper::clear_code + 1; code < nodes.size(); code++)
+		{
+			result.push_back({ nodes[code].parent, nodes[code].character });
+		}
+
+		return result;
+	}
+
+	//Not const, lookups decide which nodes get dense table
+	const DictionaryNode* at(std::size_t parent, unsigned char character)
+	{
+		auto child = findChild(parent, character);
+		LZW_STAT(Stats::local().probe(last_probes));
+
+		return child ? &nodes[child] : nullptr;
+	}
+
+	const DictionaryNode* at(std::size_t realID) const
+	{
+		return &nodes[realID];
+	}
+
+	std::size_t getNodeRealID(const DictionaryNode* node) const
+	{
+		return static_cast<const TrieNode*>(node) - nodes.data();
+	}
+
+	//RealID is already insertion order
+	std::size_t getCode(std::size_t realID) const
+	{
+		return realID;
+	}
+
+	std::size_t getBaseNodeRealID(unsigned char x) const
+	{
+		//Roots are inserted first
+		return static_cast<std::size_t>(x) + 1;
+	}
+
+	//Load memory which will be needed by at(parent, character)
+	void prefetch(std::size_t parent, unsigned char character) const
+	{
+		auto& node = nodes[parent];
+
+		if (node.dense)
+		{
+			DictionaryHashTableHelper::prefetch(&dense_tables[node.dense - 1][character]);
+		}
+		else
+		{
+			DictionaryHashTableHelper::prefetch(&nodes[node.first_child]);
+		}
+	}
+
+private:
+	//Links are next to node, so walking siblings touches one cache line per node
+	struct TrieNode : DictionaryNode
+	{
+		std::uint32_t first_child{};
+		std::uint32_t next_sibling{};
+		//Index of dense table + 1, 0 if node uses sibling list
+		std::uint32_t dense{};
+		//Length of sibling lists walked by lookups
+		std::uint32_t cost{};
+	};
+
+	std::uint32_t findChild(std::size_t parent, unsigned char character);
+
+	void insertRoots();
+	void makeDense(std::uint32_t parent);
+
+	//Node gets dense table after lookups walked this many siblings
+	static constexpr std::uint32_t dense_threshold = 256;
+
+	const std::size_t base_size;
+	//Dense tables take 1 KB each, so their count is limited
+	const std::size_t max_dense;
+	const PresetDictionary* preset;
+
+	//Node 0 is root of all ASCII characters
+	std::vector<TrieNode> nodes{};
+	std::vector<std::array<std::uint32_t, 256>> dense_tables{};
+	std::size_t dense_used{};
+
+	//State after roots and preset, clear copies it back instead of inserting them again
+	std::vector<TrieNode> initial_nodes{};
+	std::vector<std::array<std::uint32_t, 256>> initial_dense{};
+
+	//Probes of last findChild
+	LZW_STAT(std::uint32_t last_probes{};)
+};
+
+inline DictionaryTrie::DictionaryTrie(std::size_t base_size, const PresetDictionary* preset) : base_size{ base_size },
+	max_dense{ std::max<std::size_t>(base_size / 256, 1) }, preset{ preset }
+{
+	insertRoots();
+
+	initial_nodes = nodes;
+	initial_dense.assign(dense_tables.begin(), dense_tables.begin() + dense_used);
+}
+
+inline void DictionaryTrie::insertRoots()
+{
+	nodes.clear();
+	dense_used = 0;
+
+	nodes.emplace_back();
+
+	//Root has all 256 children, so it is always dense
+	makeDense(0);
+
+	for (int i = 0; i <= 255; i++)
+	{
+		insert({ 0, static_cast<unsigned char>(i) });
+	}
+
+	//Node of clear_code, it is not child of any node
+	nodes.emplace_back();
+
+	//Code of preset phrase is its realID
+	for (std::size_t i = 0; preset && i < preset->size(); i++)
+	{
+		insert({ preset->parent(i), preset->character(i) });
+	}
+}
+
+inline void DictionaryTrie::clear()
+{
+	//Vectors keep their capacity, so clear doesn't allocate again
+	nodes.assign(initial_nodes.begin(), initial_nodes.end());
+	std::copy(initial_dense.begin(), initial_dense.end(), dense_tables.begin());
+	dense_used = initial_dense.size();
+}
+
+inline void DictionaryTrie::makeDense(std::uint32_t parent)
+{
+	if (dense_used == dense_tables.size())
+	{
+		dense_tables.emplace_back();
+	}
+
+	auto& table = dense_tables[dense_used];
+	std::fill(table.begin(), table.end(), 0);
+
+	for (auto child = nodes[parent].first_child; child; child = nodes[child].next_sibling)
+	{
+		table[nodes[child].character] = child;
+	}
+
+	nodes[parent].dense = static_cast<std::uint32_t>(++dense_used);
+}
+
+inline std::uint32_t DictionaryTrie::findChild(std::size_t parent, unsigned char character)
+{
+	auto& node = nodes[parent];
+
+	if (node.dense)
+	{
+		LZW_STAT(last_probes = 1);
+		return dense_tables[node.dense - 1][character];
+	}
+
+	std::uint32_t found{};
+	std::uint32_t steps{};
+
+	for (auto child = node.first_child; child; child = nodes[child].next_sibling)
+	{
+		steps++;
+
+		if (nodes[child].character == character)
+		{
+			found = child;
+			break;
+		}
+	}
+
+	LZW_STAT(last_probes = std::max<std::uint32_t>(steps, 1));
+
+	//Short lists are as fast as table
+	if (steps > 2)
+	{
+		node.cost += steps;
+
+		if (node.cost >= dense_threshold && dense_used < max_dense)
+		{
+			makeDense(static_cast<std::uint32_t>(parent));
+		}
+	}
+
+	return found;
+}
+
+inline std::size_t DictionaryTrie::insert(const DictionaryNode& node)
+{
+	//If node already exists return it position
+	if (auto child = findChild(node.parent, node.character))
+		return child;
+
+	if (nodes.size() >= base_size)
+		return 0;
+
+	auto realID = static_cast<std::uint32_t>(nodes.size());
+
+	TrieNode child{};
+	child.parent = node.parent;
+	child.character = node.character;
+	child.next_sibling = nodes[node.parent].first_child;
+	nodes.push_back(child);
+
+	auto& parent = nodes[node.parent];
+
+	//Sibling list is kept even for dense nodes, it is not used for lookups there
+	parent.first_child = realID;
+
+	if (parent.dense)
+	{
+		dense_tables[parent.dense - 1][node.character] = realID;
+	}
+
+	return realID;
+}
@@ -7,24 +7,96 @@
 #include <numeric>
 #include <algorithm>
 #include <iterator>
-
-#include "numberscoder.h"
-#include "HashTable.h"
+#include <string>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <limits>
+#include <charconv>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+
+#include "LZWCoder.h"
+#include "LZ77Coder.h"
+#include "ChunkTable.h"
+#include "AsyncFileIO.h"
 
 
 namespace ProgramSettings
 {
 	//Size of hash table
 	constexpr std::size_t DHT_base_size = 10 * 1000ull * 1024ull;
+	//Approximate memory used by one slot of dictionary, gives base size of chunk workers
+	constexpr std::size_t bytes_per_slot = 16;
+	//Phrase codes and links are 32 bit, so slot index and every code has to fit in them
+	constexpr std::uint64_t max_base_size = std::numeric_limits<std::uint32_t>::max();
 }
 
+//Settings given in command line
+struct CodingOptions
+{
+	IOMode io_mode{ FileIOHelper::defaultMode() };
+	bool async_io{ true };
+	//Engine: lzw or lz77, lz77 gives faster coding and decoding with worse ratio
+	std::string engine{ "lzw" };
+	//Effort of lz77 encoder, 1-9
+	std::uint64_t level{ 5 };
+	//Dictionary policy: slow, fast, swiss, trie or adaptive
+	//adaptive is good for small and big files, slow is pathological on big ones
+	std::string dictionary{ "adaptive" };
+	//When encoder clears dictionary, decoder follows clear_code
+	ResetMode reset{ ResetMode::full };
+	//0 codes single stream, otherwise file is cut to chunks coded by this number of threads
+	std::size_t threads{ 0 };
+	std::uint64_t chunk_size{ 16 * 1024 * 1024 };
+	//Memory for dictionary of one worker, decoder also limits size of one decoded chunk by it
+	std::uint64_t worker_memory{ 64 * 1024 * 1024 };
+	//Memory for dictionary of single stream, 0 uses DHT_base_size
+	//Decoder needs the same value, it gives size limit of dictionary
+	std::uint64_t memory{ 0 };
+	//Byte aligned segment at every reset and at least every chunk_size bytes, index at the end
+	bool seekable{ false };
+	//Encoder finds two character phrases in direct table, output is the same
+	bool pair_table{ false };
+	//Decode only [offset, offset + length) of uncompressed data
+	std::optional<std::pair<std::uint64_t, std::uint64_t>> range{};
+	//JSON summary of instrumentation, only with LZW_STATS
+	std::string stats_file{};
+	//Trained phrases which every dictionary starts with, decoder needs the same file
+	//It is loaded once and all workers read it
+	std::shared_ptr<const PresetDictionary> preset{};
+	//Number of phrases selected by train
+	std::uint64_t preset_size{ 4096 };
+	//State of single stream encoder is saved here after coding
+	std::string snapshot_file{};
+	//Continue stream from snapshot_file, only input after its end is coded and output is cut to its end
+	bool append{ false };
+};
+
 template <typename NC, typename SPEED>
-std::optional<std::tuple<std::uint64_t, std::size_t, double, double, double, double>> code(std::string_view input_file, std::string_view output_file);
-using code_function = std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>>(*)(std::string_view, std::string_view);
+std::optional<std::tuple<std::uint64_t, std::size_t, double, double, double, double>> code(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+using code_function = std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>>(*)(std::string_view, std::string_view, const CodingOptions&);
 
 template <typename NC, typename SPEED>
-bool decode(std::string_view input_file, std::string_view output_file);
-using decode_function = bool(*)(std::string_view, std::string_view);
+bool decode(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+using decode_function = bool(*)(std::string_view, std::string_view, const CodingOptions&);
+
+template <typename NC, typename SPEED>
+bool codeBatch(const std::vector<std::filesystem::path>& inputs, const std::vector<std::filesystem::path>& outputs, const CodingOptions& options);
+using batch_function = bool(*)(const std::vector<std::filesystem::path>&, const std::vector<std::filesystem::path>&, const CodingOptions&);
+
+template <typename NC>
+std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> codeLZ77(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+
+template <typename NC>
+bool decodeLZ77(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+
+void benchmarkCoders(std::size_t count);
+
+bool benchmarkHashes(const std::string& corpus, const CodingOptions& options);
+
+bool trainPreset(const std::filesystem::path& corpus, std::string_view output_file, std::size_t preset_size);
 
 template <typename SPEED>
 code_function getCodeFunction(std::string_view NC)
@@ -37,6 +109,10 @@ code_function getCodeFunction(std::string_view NC)
 		return code<NumbersCoder<E_omega>, SPEED>;
 	if (NC == "fib")
 		return code<NumbersCoder<fib>, SPEED>;
+	if (NC == "binary")
+		return code<NumbersCoder<binary>, SPEED>;
+	if (NC == "auto")
+		return code<NumbersCoder<blockwise>, SPEED>;
 
 	return nullptr;
 }
@@ -52,33 +128,400 @@ decode_function getDecodeFunction(std::string_view NC)
 		return decode<NumbersCoder<E_omega>, SPEED>;
 	if (NC == "fib")
 		return decode<NumbersCoder<fib>, SPEED>;
+	if (NC == "binary")
+		return decode<NumbersCoder<binary>, SPEED>;
+	if (NC == "auto")
+		return decode<NumbersCoder<blockwise>, SPEED>;
+
+	return nullptr;
+}
+
+template <typename SPEED>
+batch_function getBatchFunction(std::string_view NC)
+{
+	if (NC == "gamma")
+		return codeBatch<NumbersCoder<E_gamma>, SPEED>;
+	if (NC == "delta")
+		return codeBatch<NumbersCoder<E_delta>, SPEED>;
+	if (NC == "omega")
+		return codeBatch<NumbersCoder<E_omega>, SPEED>;
+	if (NC == "fib")
+		return codeBatch<NumbersCoder<fib>, SPEED>;
+	if (NC == "binary")
+		return codeBatch<NumbersCoder<binary>, SPEED>;
+	if (NC == "auto")
+		return codeBatch<NumbersCoder<blockwise>, SPEED>;
+
+	return nullptr;
+}
+
+code_function getCodeFunction(std::string_view dictionary, std::string_view NC)
+{
+	if (dictionary == "slow")
+		return getCodeFunction<DictionaryHashTableHelper::slow>(NC);
+	if (dictionary == "fast")
+		return getCodeFunction<DictionaryHashTableHelper::fast>(NC);
+	if (dictionary == "swiss")
+		return getCodeFunction<DictionaryHashTableHelper::swiss>(NC);
+	if (dictionary == "trie")
+		return getCodeFunction<DictionaryHashTableHelper::trie>(NC);
+	if (dictionary == "adaptive")
+		return getCodeFunction<DictionaryHashTableHelper::adaptive>(NC);
+
+	return nullptr;
+}
+
+decode_function getDecodeFunction(std::string_view dictionary, std::string_view NC)
+{
+	if (dictionary == "slow")
+		return getDecodeFunction<DictionaryHashTableHelper::slow>(NC);
+	if (dictionary == "fast")
+		return getDecodeFunction<DictionaryHashTableHelper::fast>(NC);
+	if (dictionary == "swiss")
+		return getDecodeFunction<DictionaryHashTableHelper::swiss>(NC);
+	if (dictionary == "trie")
+		return getDecodeFunction<DictionaryHashTableHelper::trie>(NC);
+	if (dictionary == "adaptive")
+		return getDecodeFunction<DictionaryHashTableHelper::adaptive>(NC);
+
+	return nullptr;
+}
+
+code_function getLZ77CodeFunction(std::string_view NC)
+{
+	if (NC == "gamma")
+		return codeLZ77<NumbersCoder<E_gamma>>;
+	if (NC == "delta")
+		return codeLZ77<NumbersCoder<E_delta>>;
+	if (NC == "omega")
+		return codeLZ77<NumbersCoder<E_omega>>;
+	if (NC == "fib")
+		return codeLZ77<NumbersCoder<fib>>;
+	if (NC == "binary")
+		return codeLZ77<NumbersCoder<binary>>;
+	if (NC == "auto")
+		return codeLZ77<NumbersCoder<blockwise>>;
+
+	return nullptr;
+}
+
+decode_function getLZ77DecodeFunction(std::string_view NC)
+{
+	if (NC == "gamma")
+		return decodeLZ77<NumbersCoder<E_gamma>>;
+	if (NC == "delta")
+		return decodeLZ77<NumbersCoder<E_delta>>;
+	if (NC == "omega")
+		return decodeLZ77<NumbersCoder<E_omega>>;
+	if (NC == "fib")
+		return decodeLZ77<NumbersCoder<fib>>;
+	if (NC == "binary")
+		return decodeLZ77<NumbersCoder<binary>>;
+	if (NC == "auto")
+		return decodeLZ77<NumbersCoder<blockwise>>;
+
+	return nullptr;
+}
+
+batch_function getBatchFunction(std::string_view dictionary, std::string_view NC)
+{
+	if (dictionary == "slow")
+		return getBatchFunction<DictionaryHashTableHelper::slow>(NC);
+	if (dictionary == "fast")
+		return getBatchFunction<DictionaryHashTableHelper::fast>(NC);
+	if (dictionary == "swiss")
+		return getBatchFunction<DictionaryHashTableHelper::swiss>(NC);
+	if (dictionary == "trie")
+		return getBatchFunction<DictionaryHashTableHelper::trie>(NC);
+	if (dictionary == "adaptive")
+		return getBatchFunction<DictionaryHashTableHelper::adaptive>(NC);
 
 	return nullptr;
 }
 
+//Input is directory or file with list of files, output file is input path in output directory with .lzw
+bool listBatchFiles(const std::filesystem::path& input, const std::filesystem::path& output_directory, std::vector<std::filesystem::path>& inputs, std::vector<std::filesystem::path>& outputs)
+{
+	std::error_code error{};
+
+	if (std::filesystem::is_directory(input, error))
+	{
+		for (auto& entry : std::filesystem::recursive_directory_iterator{ input, error })
+		{
+			if (entry.is_regular_file())
+			{
+				inputs.push_back(entry.path());
+				outputs.push_back(output_directory / std::filesystem::relative(entry.path(), input));
+			}
+		}
+	}
+	else
+	{
+		std::ifstream list{ input };
+
+		if (!list)
+			return false;
+
+		for (std::string line{}; std::getline(list, line);)
+		{
+			if (line.empty())
+				continue;
+
+			std::filesystem::path path{ line };
+			inputs.push_back(path);
+			outputs.push_back(output_directory / path.relative_path());
+		}
+	}
+
+	for (auto& output : outputs)
+	{
+		output += ".lzw";
+	}
+
+	return !error;
+}
+
+//Positive whole number, multiplied by unit
+bool parseNumber(std::string_view value, std::uint64_t unit, std::uint64_t& result)
+{
+	std::uint64_t number{};
+	auto [ptr, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+
+	if (error != std::errc{} || ptr != value.data() + value.size() || number == 0 || number > std::numeric_limits<std::uint64_t>::max() / unit)
+		return false;
+
+	result = number * unit;
+
+	return true;
+}
+
+bool parseOption(std::string_view option, CodingOptions& options)
+{
+	//Options have form --name=value
+	auto separator = option.find('=');
+	if (separator == std::string_view::npos)
+		return false;
+
+	auto name = option.substr(2, separator - 2);
+	auto value = option.substr(separator + 1);
+
+	if (name == "io")
+	{
+		if (value == "stream")
+			options.io_mode = IOMode::stream;
+		else if (value == "mmap")
+			options.io_mode = IOMode::mapped;
+		else
+			return false;
+
+		return true;
+	}
+
+	if (name == "reset")
+	{
+		if (value == "full")
+			options.reset = ResetMode::full;
+		else if (value == "adaptive")
+			options.reset = ResetMode::adaptive;
+		else
+			return false;
+
+		return true;
+	}
+
+	if (name == "engine")
+	{
+		if (value != "lzw" && value != "lz77")
+			return false;
+
+		options.engine = value;
+
+		return true;
+	}
+
+	if (name == "level")
+		return parseNumber(value, 1, options.level) && options.level <= LZ77Helper::max_level;
+
+	if (name == "dictionary")
+	{
+		options.dictionary = value;
+
+		return true;
+	}
+
+	if (name == "threads")
+	{
+		std::uint64_t threads{};
+		if (!parseNumber(value, 1, threads))
+			return false;
+
+		options.threads = threads;
+
+		return true;
+	}
+
+	if (name == "chunk-size")
+		return parseNumber(value, 1024 * 1024, options.chunk_size);
+
+	//Memory is given in MB and it gives base size of dictionary
+	if (name == "worker-memory")
+		return parseNumber(value, 1024 * 1024, options.worker_memory) && options.worker_memory / ProgramSettings::bytes_per_slot <= ProgramSettings::max_base_size;
+
+	if (name == "memory")
+		return parseNumber(value, 1024 * 1024, options.memory) && options.memory / ProgramSettings::bytes_per_slot <= ProgramSettings::max_base_size;
+
+	if (name == "seekable")
+	{
+		if (value == "on")
+			options.seekable = true;
+		else if (value == "off")
+			options.seekable = false;
+		else
+			return false;
+
+		return true;
+	}
+
+	if (name == "pair-table")
+	{
+		if (value == "on")
+			options.pair_table = true;
+		else if (value == "off")
+			options.pair_table = false;
+		else
+			return false;
+
+		return true;
+	}
+
+	if (name == "range")
+	{
+		//offset:length
+		auto colon = value.find(':');
+		if (colon == std::string_view::npos)
+			return false;
+
+		std::uint64_t offset{}, length{};
+		auto [offset_end, offset_error] = std::from_chars(value.data(), value.data() + colon, offset);
+		auto [length_end, length_error] = std::from_chars(value.data() + colon + 1, value.data() + value.size(), length);
+
+		if (offset_error != std::errc{} || offset_end != value.data() + colon || length_error != std::errc{} || length_end != value.data() + value.size())
+			return false;
+
+		options.range = { offset, length };
+
+		return true;
+	}
+
+	if (name == "preset")
+	{
+		options.preset = PresetDictionary::load(std::string{ value });
+
+		return static_cast<bool>(options.preset);
+	}
+
+	if (name == "preset-size")
+		return parseNumber(value, 1, options.preset_size);
+
+	if (name == "snapshot")
+	{
+		options.snapshot_file = value;
+
+		return true;
+	}
+
+#ifdef LZW_STATS
+	if (name == "stats")
+	{
+		options.stats_file = value;
+
+		return true;
+	}
+#endif
+
+	if (name == "async-io")
+	{
+		if (value == "on")
+			options.async_io = true;
+		else if (value == "off")
+			options.async_io = false;
+		else
+			return false;
+
+		return true;
+	}
+
+	return false;
+}
+
 int main(int argc, char** argv)
 {
 	std::ios_base::sync_with_stdio(false);
 
-	if (argc < 4)
+	std::vector<std::string> args{};
+	CodingOptions options{};
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view arg = argv[i];
+
+		if (arg.substr(0, 2) != "--")
+		{
+			args.emplace_back(arg);
+		}
+		else if (!parseOption(arg, options))
+		{
+			std::cout << "Invalid option: " << arg << "\n";
+			return 0;
+		}
+	}
+
+	if (!args.empty() && args[0] == "bench")
+	{
+		//bench [number of codes]
+		benchmarkCoders(args.size() > 1 ? std::stoull(args[1]) : 10'000'000);
+		return 0;
+	}
+
+	if (!args.empty() && args[0] == "bench-hash")
+	{
+		//bench-hash corpus_file, hash policies of fast and swiss dictionary
+		if (args.size() < 2 || !benchmarkHashes(args[1], options))
+		{
+			std::cout << "Oh, no. Something went wrong\n";
+		}
+
+		return 0;
+	}
+
+	if (args.size() < 3)
 	{
 		std::cout << "Invalid arguments\n";
 		return 0;
 	}
 
-	std::string input_file = argv[2];
-	std::string output_file = argv[3];
+	std::string input_file = args[1];
+	std::string output_file = args[2];
 	std::string numbers_coding = "omega";
 
-	if (argc == 5)
+	if (args.size() == 4)
 	{
-		numbers_coding = argv[4];
+		numbers_coding = args[3];
 	}
 
-	std::string job = argv[1];
+	std::string job = args[0];
 
-	if (job == "code")
+	if (job == "code" || job == "append")
 	{
+		//append input output [coder] --snapshot=file, input has to start with data coded before
+		options.append = job == "append";
+
+		if (options.append && options.snapshot_file.empty())
+		{
+			std::cout << "Append needs --snapshot\n";
+			return 0;
+		}
+
 		double entropy2{};
 		bool success{ false };
 		double entropy{}, avg_length{};
@@ -86,529 +529,1346 @@ int main(int argc, char** argv)
 		std::uint64_t sizeC{};
 		std::uint64_t sizeU{};
 
-		//DictionaryHashTableHelper::fast faster encoding, great for big files, terrible for small
-		//DictionaryHashTableHelper::slow slower encoding, terrible for big files, good for small
-		auto coder = getCodeFunction<DictionaryHashTableHelper::slow>(numbers_coding);
+		//DictionaryHashTableHelper::fast faster encoding, great for big files, terrible for small
+		//DictionaryHashTableHelper::slow slower encoding, terrible for big files, good for small
+		//DictionaryHashTableHelper::swiss group probing, fast for big files
+		//DictionaryHashTableHelper::trie no hashing, small codes like slow
+		//DictionaryHashTableHelper::adaptive grows with input, good for small and big files
+		//--engine=lz77 hash chain matcher instead of dictionary, fast coding and very fast decoding
+		auto coder = options.engine == "lz77" ? getLZ77CodeFunction(numbers_coding) : getCodeFunction(options.dictionary, numbers_coding);
+
+		if (!coder)
+		{
+			std::cout << "Invalid coder or dictionary\n";
+			return 0;
+		}
+
+		auto x = coder(input_file, output_file, options);
+
+		if (!x.has_value())
+		{
+			success = false;
+		}
+		else
+		{
+			success = true;
+			std::tie(sizeC, sizeU, entropy, entropy2, avg_length, level) = x.value();
+		}
+
+		if (!success)
+		{
+			std::cout << "Oh, no. Something went wrong\n";
+			return 0;
+		}
+
+		std::cout << "Compressed file emtropy: " << entropy2 << "\n";
+		std::cout << "Compressed file size: " << sizeC << "\n";
+		std::cout << "Uncompressed file emtropy: " << entropy << "\n";
+		std::cout << "Uncompressed file size: " << sizeU << "\n";
+		std::cout << "Arg codeword length: " << avg_length << "\n";
+		std::cout << "CR: " << level << "\n";
+
+#ifdef LZW_STATS
+		if (!options.stats_file.empty())
+		{
+			Stats::flush();
+			std::ofstream stats_out{ options.stats_file };
+			Stats::total().writeJSON(stats_out);
+		}
+#endif
+	}
+	else if (job == "train")
+	{
+		//train corpus_file|directory preset_file
+		if (!trainPreset(input_file, output_file, options.preset_size))
+		{
+			std::cout << "Oh, no. Something went wrong\n";
+			return 0;
+		}
+	}
+	else if (job == "batch")
+	{
+		//batch directory|list output_directory [coder]
+		auto coder = options.engine == "lzw" ? getBatchFunction(options.dictionary, numbers_coding) : nullptr;
+
+		if (!coder)
+		{
+			std::cout << "Invalid coder or dictionary\n";
+			return 0;
+		}
+
+		std::vector<std::filesystem::path> inputs{};
+		std::vector<std::filesystem::path> outputs{};
+
+		if (!listBatchFiles(input_file, output_file, inputs, outputs) || !coder(inputs, outputs, options))
+		{
+			std::cout << "Oh, no. Something went wrong\n";
+			return 0;
+		}
+	}
+	else if (job == "decode")
+	{
+		auto decoder = options.engine == "lz77" ? getLZ77DecodeFunction(numbers_coding) : getDecodeFunction(options.dictionary, numbers_coding);
+
+		if (!decoder)
+		{
+			std::cout << "Invalid coder or dictionary\n";
+			return 0;
+		}
+
+		auto x = decoder(input_file, output_file, options);
+
+		if (!x)
+		{
+			std::cout << "Oh, no. Something went wrong\n";
+			return 0;
+		}
+	}
+	else
+	{
+		std::cout << "Invalid job\n";
+		return 0;
+	}
+
+	return 0;
+}
+
+
+bool checkFiles(std::string_view input_file, std::string_view output_file)
+{
+	return input_file != output_file;
+}
+
+//Move all whole bytes from writer to file
+template <typename IO>
+std::uint64_t dumpBits(BitWriter& writer, IO& file_IO, std::vector<std::uint64_t>& characters_c_count)
+{
+	LZW_STAT(PhaseTimer timer{ Stats::write });
+
+	auto& bytes = writer.flush();
+
+	for (auto x : bytes)
+	{
+		characters_c_count[x]++;
+	}
+
+	auto size = bytes.size();
+	file_IO.write(bytes);
+
+	return size;
+}
+
+//Sizes, entropies, average codeword length and compression ratio
+std::tuple<std::uint64_t, std::uint64_t, double, double, double, double> codingStats(std::uint64_t saved, std::uint64_t loaded, const std::vector<std::uint64_t>& characters_u_count, const std::vector<std::uint64_t>& characters_c_count)
+{
+	//Calculate Entropy
+	std::uint64_t size_u = std::accumulate(characters_u_count.begin(), characters_u_count.end(), std::uint64_t{});
+	std::uint64_t size_c = std::accumulate(characters_c_count.begin(), characters_c_count.end(), std::uint64_t{});
+	double H_u_tmp = 1;
+	double H_c_tmp = 1;
+	for (auto&& x : characters_u_count)
+	{
+		if (x == 0) continue;
+
+		H_u_tmp *= std::pow(x / (double)size_u, x / (double)size_u);
+
+	}
+
+	for (auto&& x : characters_c_count)
+	{
+		if (x == 0) continue;
+
+		H_c_tmp *= std::pow(x / (double)size_c, x / (double)size_c);
+
+	}
+
+	double H_u = static_cast<double>(std::abs(std::log2l(H_u_tmp)));
+	double H_c = static_cast<double>(std::abs(std::log2l(H_c_tmp)));
+
+	return { saved, loaded, H_u, H_c, (8.0 * saved) / (double)loaded, (double)loaded / (double)saved };
+}
+
+template <typename NC, typename SPEED>
+std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> codeChunked(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+
+template <typename NC, typename SPEED>
+bool decodeChunked(std::string_view input_file, std::string_view output_file, const CodingOptions& options);
+
+//Base size of single stream dictionary
+std::size_t baseSize(const CodingOptions& options)
+{
+	return options.memory ? options.memory / ProgramSettings::bytes_per_slot : ProgramSettings::DHT_base_size;
+}
+
+std::size_t presetSize(const CodingOptions& options)
+{
+	return options.preset ? options.preset->size() : 0;
+}
+
+//Preset can take at most half of dictionary, the rest is left for phrases of input
+template <typename SPEED>
+bool presetFits(const CodingOptions& options, std::size_t base_size)
+{
+	return DictionaryHashTableHelper::clear_code + 1 + presetSize(options) <= Dictionary<SPEED>::capacity(base_size) / 2;
+}
+
+//Snapshot has to be made with options which give the same codes
+template <typename SPEED>
+bool readSnapshot(const CodingOptions& options, StreamSnapshot& snapshot)
+{
+	std::ifstream file{ options.snapshot_file, std::ios_base::binary };
+	std::vector<unsigned char> data(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+
+	return snapshot.parse(data.data(), data.size()) && snapshot.dictionary == SPEED::value && snapshot.base_size == baseSize(options)
+		&& snapshot.preset_size == presetSize(options) && snapshot.reset_mode == static_cast<std::uint64_t>(options.reset);
+}
+
+template <typename SPEED>
+bool writeSnapshot(const CodingOptions& options, StreamSnapshot& snapshot)
+{
+	snapshot.dictionary = SPEED::value;
+	snapshot.base_size = baseSize(options);
+	snapshot.preset_size = presetSize(options);
+	snapshot.reset_mode = static_cast<std::uint64_t>(options.reset);
+
+	auto data = snapshot.serialize();
+	std::ofstream file{ options.snapshot_file, std::ios_base::binary };
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	file.close();
+
+	return static_cast<bool>(file);
+}
+
+template <typename NC, typename SPEED>
+std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> code(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
+{
+	if (!checkFiles(input_file, output_file))
+	{
+		return {};
+	}
+
+	//Snapshot is state of one stream, chunks and segments are not continued
+	//Blockwise coder keeps codes of unfinished block, snapshot has only bits of output
+	if (!options.snapshot_file.empty() && (options.threads > 0 || options.seekable || std::is_same_v<NC, NumbersCoder<blockwise>>))
+	{
+		return {};
+	}
+
+	if (options.threads > 0)
+	{
+		return codeChunked<NC, SPEED>(input_file, output_file, options);
+	}
+
+	if (!presetFits<SPEED>(options, baseSize(options)))
+	{
+		return {};
+	}
+
+	//Small input doesn't need whole dictionary
+	std::error_code error{};
+	auto input_size = std::filesystem::file_size(input_file, error);
+
+	//Appended input continues after end of snapshot, output is cut to its whole bytes
+	StreamSnapshot snapshot{};
+
+	if (options.append)
+	{
+		std::error_code output_error{};
+
+		if (error || !readSnapshot<SPEED>(options, snapshot) || input_size < snapshot.input_size
+			|| std::filesystem::file_size(output_file, output_error) < snapshot.output_size || output_error)
+		{
+			return {};
+		}
+	}
+
+	//Dictionary of appending run gets phrases of snapshot and new input
+	LZWEncoder<NC, SPEED> encoder{ LZWCoderHelper::fittingBaseSize<SPEED>(baseSize(options),
+		error ? std::numeric_limits<std::uint64_t>::max() : input_size - snapshot.input_size + snapshot.phrases.size(), presetSize(options)),
+		options.reset, options.preset.get() };
+
+	if (options.seekable)
+	{
+		encoder.enableSegments(options.chunk_size);
+	}
+
+	if (options.pair_table)
+	{
+		encoder.enablePairTable();
+	}
+
+	//Input buffer
+	const unsigned char* it{ nullptr };
+	const unsigned char* in_end{ nullptr };
+
+	//Output buffer for number encoding
+	BitWriter out{};
+
+	//Output is cut only if snapshot gives valid dictionary
+	if (options.append && !encoder.resume(snapshot, out))
+	{
+		return {};
+	}
+
+	AsyncFileIO file_IO{ input_file, output_file, options.io_mode, options.async_io, snapshot.input_size, snapshot.output_size };
+
+	if (!file_IO.isValid())
+	{
+		return {};
+	}
+
+	const std::size_t max_buffer_size = file_IO.outputBufferSize();
+
+	//Entropy
+	std::vector<std::uint64_t> characters_c_count{};
+	std::vector<std::uint64_t> characters_u_count{};
+	characters_u_count.resize(256);
+	characters_c_count.resize(256);
+
+	std::uint64_t loaded{};
+	std::uint64_t saved{};
+
+	while (true)
+	{
+		{
+			//Load input buffer from file
+			LZW_STAT(PhaseTimer timer{ Stats::read });
+
+			if (!file_IO.read(it, in_end))
+				break;
+		}
+
+		//Part is coded in pieces of at most 1 MB, so output buffer is dumped in time
+		while (it != in_end)
+		{
+			auto piece_end = it + std::min<std::uint64_t>(in_end - it, 1024000 - loaded % 1024000);
+
+			for (auto c = it; c != piece_end; c++)
+			{
+				characters_u_count[*c]++;
+			}
+
+			encoder.code(it, piece_end, out);
+			loaded += piece_end - it;
+			it = piece_end;
+
+			if (out.size() > max_buffer_size)
+			{
+				//dump output_buffer to file
+				saved += dumpBits(out, file_IO, characters_c_count);
+
+				if (!file_IO.isValid())
+				{
+					return {};
+				}
+			}
+
+			if (loaded % 1024000 == 0)
+			{
+				std::clog << loaded / 1024000 << " MB\n";
+			}
+		}
+	}
+
+	if (!options.snapshot_file.empty())
+	{
+		//Snapshot is taken before last phrase, it is written again by next run
+		saved += dumpBits(out, file_IO, characters_c_count);
+
+		auto output_start = snapshot.output_size;
+		snapshot = encoder.snapshot(out);
+		snapshot.output_size = output_start + saved;
+	}
+
+	encoder.finish(out);
+
+	saved += dumpBits(out, file_IO, characters_c_count);
+
+	if (options.seekable)
+	{
+		//Index of segments is the same table as in chunked stream
+		auto table_data = ChunkTable{ baseSize(options), encoder.getSegments() }.serialize();
+		saved += table_data.size();
+		file_IO.write(table_data);
+	}
+
+	//Snapshot is saved only for complete output, next run would append to missing data
+	if (!file_IO.finish() || (!options.snapshot_file.empty() && !writeSnapshot<SPEED>(options, snapshot)))
+	{
+		return {};
+	}
+
+	return codingStats(saved, loaded, characters_u_count, characters_c_count);
+}
+
+template <typename NC, typename SPEED>
+bool decode(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
+{
+	if (!checkFiles(input_file, output_file))
+	{
+		return false;
+	}
+
+	if (options.threads > 0 || options.seekable || options.range)
+	{
+		return decodeChunked<NC, SPEED>(input_file, output_file, options);
+	}
+
+	if (!presetFits<SPEED>(options, baseSize(options)))
+	{
+		return false;
+	}
+
+	AsyncFileIO file_IO{ input_file, output_file, options.io_mode, options.async_io };
+
+	if (!file_IO.isValid())
+	{
+		return false;
+	}
+
+	//Its size limit has to be the same as in encoder
+	LZWDecoder<NC> decoder{ Dictionary<SPEED>::capacity(baseSize(options)), options.preset.get() };
+
+	//Number deencoder buffer, pulls data from file
+	BitReader<AsyncFileIO> in{ file_IO };
+
+	//Output buffer, phrases are written directly to it
+	std::vector<unsigned char> out_buffer{};
+	std::size_t out_pos{};
+
+	auto success = decoder.decode(in, out_buffer, out_pos, file_IO.outputBufferSize(), [&](std::size_t size)
+	{
+		//Save output buffer to file
+		out_buffer.resize(size);
+		std::clog << in.consumed() / (1024000 * 8) << " MB\n";
+
+		return file_IO.write(out_buffer);
+	});
+
+	if (!success)
+	{
+		return false;
+	}
+
+	out_buffer.resize(out_pos);
+
+	return file_IO.write(out_buffer) && file_IO.finish();
+}
+
+//Chunks are coded by worker threads, every chunk is independent stream with new dictionary
+//Results are written in order, at most 2 chunks per worker are in memory
+template <typename NC, typename SPEED>
+std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> codeChunked(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
+{
+	FileIO file_IO{ input_file, output_file, options.io_mode };
+
+	if (!file_IO.isValid())
+	{
+		return {};
+	}
+
+	ChunkTable table{ options.worker_memory / ProgramSettings::bytes_per_slot };
+
+	if (!presetFits<SPEED>(options, table.base_size))
+	{
+		return {};
+	}
+
+	struct Job
+	{
+		std::vector<unsigned char> input{};
+		//Coded chunk and its segments
+		std::promise<std::pair<std::vector<unsigned char>, std::vector<ChunkEntry>>> result{};
+	};
+
+	//nullptr stops worker, at most 2 chunks per worker are waiting
+	BoundedQueue<std::unique_ptr<Job>> jobs{ 2 * options.threads };
+	std::vector<std::thread> workers{};
+
+	for (std::size_t i = 0; i < options.threads; i++)
+	{
+		workers.emplace_back([&jobs, &table, &options]
+		{
+			//Dictionary of worker is reused for all its chunks
+			LZWEncoder<NC, SPEED> encoder{ LZWCoderHelper::fittingBaseSize<SPEED>(table.base_size, options.chunk_size, presetSize(options)), options.reset, options.preset.get() };
+
+			if (options.seekable)
+			{
+				encoder.enableSegments(options.chunk_size);
+			}
+
+			if (options.pair_table)
+			{
+				encoder.enablePairTable();
+			}
+
+			while (auto job = jobs.pop())
+			{
+				BitWriter out{};
+
+				encoder.restart();
+				encoder.code(job->input.data(), job->input.data() + job->input.size(), out);
+				encoder.finish(out);
+
+				auto& data = out.flush();
+				auto segments = options.seekable ? encoder.getSegments() : std::vector<ChunkEntry>{ { job->input.size(), data.size() } };
+
+				job->result.set_value({ std::move(data), std::move(segments) });
+			}
+
+			LZW_STAT(Stats::flush());
+		});
+	}
+
+	//Entropy
+	std::vector<std::uint64_t> characters_c_count(256);
+	std::vector<std::uint64_t> characters_u_count(256);
+
+	std::uint64_t loaded{};
+	std::uint64_t saved{};
+
+	//Results of chunks in order
+	std::deque<std::future<std::pair<std::vector<unsigned char>, std::vector<ChunkEntry>>>> pending{};
+
+	std::size_t written_chunks{};
+
+	auto writeChunk = [&]
+	{
+		auto [data, segments] = pending.front().get();
+		LZW_STAT(PhaseTimer timer{ Stats::write });
+
+		for (auto x : data)
+		{
+			characters_c_count[x]++;
+		}
+
+		table.chunks.insert(table.chunks.end(), segments.begin(), segments.end());
+		saved += data.size();
+		file_IO.write(data);
+
+		pending.pop_front();
+
+		std::clog << ++written_chunks << " chunks\n";
+	};
+
+	auto chunk = std::make_unique<Job>();
+
+	auto submit = [&]
+	{
+		pending.push_back(chunk->result.get_future());
+		jobs.push(std::move(chunk));
+		chunk = std::make_unique<Job>();
+
+		if (pending.size() >= 2 * options.threads)
+		{
+			writeChunk();
+		}
+	};
+
+	const unsigned char* it{ nullptr };
+	const unsigned char* in_end{ nullptr };
+
+	while (true)
+	{
+		{
+			LZW_STAT(PhaseTimer timer{ Stats::read });
+
+			if (!file_IO.read(it, in_end))
+				break;
+		}
+
+		for (auto c = it; c != in_end; c++)
+		{
+			characters_u_count[*c]++;
+		}
+
+		loaded += in_end - it;
+
+		//Parts of file are cut to chunks
+		while (it != in_end)
+		{
+			auto count = std::min<std::uint64_t>(in_end - it, options.chunk_size - chunk->input.size());
+			chunk->input.insert(chunk->input.end(), it, it + count);
+			it += count;
+
+			if (chunk->input.size() == options.chunk_size)
+			{
+				submit();
+			}
+		}
+
+		//Workers are stopped the same way, but nothing more is written
+		if (!file_IO.isValid())
+		{
+			break;
+		}
+	}
+
+	if (!chunk->input.empty())
+	{
+		submit();
+	}
+
+	while (!pending.empty())
+	{
+		writeChunk();
+	}
+
+	for (std::size_t i = 0; i < workers.size(); i++)
+	{
+		jobs.push(nullptr);
+	}
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+
+	auto table_data = table.serialize();
+	saved += table_data.size();
+
+	if (!file_IO.write(table_data) || !file_IO.finish())
+	{
+		return {};
+	}
+
+	return codingStats(saved, loaded, characters_u_count, characters_c_count);
+}
+
+//Table is at the end of file, its footer gives its size
+bool readChunkTable(FileIO& file_IO, ChunkTable& table, std::uint64_t& table_size)
+{
+	auto file_size = file_IO.inputSize();
+
+	if (file_size < ChunkTable::footer_size)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> data{};
+
+	if (!file_IO.readAt(file_size - ChunkTable::footer_size, ChunkTable::footer_size, data))
+	{
+		return false;
+	}
+
+	table_size = ChunkTable::tableSize(data.data());
+
+	if (table_size == 0 || table_size > file_size)
+	{
+		return false;
+	}
+
+	return file_IO.readAt(file_size - table_size, table_size, data) && table.parse(data.data(), data.size());
+}
+
+template <typename NC, typename SPEED>
+bool decodeChunked(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
+{
+	FileIO file_IO{ input_file, output_file, options.io_mode };
+
+	if (!file_IO.isValid())
+	{
+		return false;
+	}
+
+	ChunkTable table{};
+	std::uint64_t table_size{};
+
+	if (!readChunkTable(file_IO, table, table_size))
+	{
+		return false;
+	}
+
+	//Table comes from file, so nothing is allocated before it is checked
+	//Dictionary can't be bigger than decoder would make for chunk worker or single stream
+	if (table.base_size > std::max<std::uint64_t>(options.worker_memory / ProgramSettings::bytes_per_slot, baseSize(options)))
+	{
+		return false;
+	}
+
+	//Chunks have to fill whole file before table
+	std::uint64_t offset{};
+	std::uint64_t uncompressed_size{};
+
+	for (auto& chunk : table.chunks)
+	{
+		if (chunk.compressed_size > file_IO.inputSize() - table_size - offset)
+		{
+			return false;
+		}
+
+		//Whole decoded chunk is kept in memory of worker
+		if (chunk.uncompressed_size > options.worker_memory || chunk.uncompressed_size > std::numeric_limits<std::uint64_t>::max() - uncompressed_size)
+		{
+			return false;
+		}
+
+		offset += chunk.compressed_size;
+		uncompressed_size += chunk.uncompressed_size;
+	}
+
+	if (offset != file_IO.inputSize() - table_size || !presetFits<SPEED>(options, table.base_size))
+	{
+		return false;
+	}
+
+	struct Job
+	{
+		std::vector<unsigned char> input{};
+		std::uint64_t size{};
+		std::promise<std::optional<std::vector<unsigned char>>> result{};
+	};
+
+	//Seekable stream can be decoded without --threads
+	auto threads = std::max<std::size_t>(options.threads, 1);
+
+	//nullptr stops worker, at most 2 chunks per worker are waiting
+	BoundedQueue<std::unique_ptr<Job>> jobs{ 2 * threads };
+	std::vector<std::thread> workers{};
+
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		workers.emplace_back([&jobs, &table, &options]
+		{
+			LZWDecoder<NC> decoder{ Dictionary<SPEED>::capacity(table.base_size), options.preset.get() };
+
+			while (auto job = jobs.pop())
+			{
+				MemoryInput memory{ job->input.data(), job->input.data() + job->input.size() };
+				BitReader<MemoryInput> in{ memory };
+
+				std::vector<unsigned char> out(job->size);
+				std::size_t out_pos{};
+
+				//Whole chunk stays in memory, so buffer is never flushed
+				decoder.restart();
+				auto success = decoder.decode(in, out, out_pos, std::numeric_limits<std::size_t>::max(), [](std::size_t) { return true; });
+
+				if (!success || out_pos != job->size)
+				{
+					job->result.set_value(std::nullopt);
+					continue;
+				}
+
+				out.resize(out_pos);
+				job->result.set_value(std::move(out));
+			}
+		});
+	}
+
+	//Result of chunk and its part inside range
+	struct PendingChunk
+	{
+		std::future<std::optional<std::vector<unsigned char>>> result{};
+		std::uint64_t skip{};
+		std::uint64_t count{};
+	};
+
+	std::deque<PendingChunk> pending{};
+	bool success{ true };
+
+	auto writeChunk = [&]
+	{
+		auto& chunk = pending.front();
+		auto data = chunk.result.get();
+
+		if (!data)
+		{
+			success = false;
+		}
+		else if (!file_IO.write(reinterpret_cast<const char*>(data->data() + chunk.skip), chunk.count))
+		{
+			success = false;
+		}
+
+		pending.pop_front();
+	};
+
+	//Whole file if there is no range
+	std::uint64_t range_begin{};
+	std::uint64_t range_end{ std::numeric_limits<std::uint64_t>::max() };
+
+	if (options.range)
+	{
+		range_begin = options.range->first;
+		range_end = range_begin + std::min(options.range->second, range_end - range_begin);
+	}
+
+	offset = 0;
+	std::uint64_t uncompressed_offset{};
 
-		auto x = coder(input_file, output_file);
+	for (auto& chunk : table.chunks)
+	{
+		auto chunk_begin = uncompressed_offset;
+		auto chunk_end = chunk_begin + chunk.uncompressed_size;
 
-		if (!x.has_value())
+		uncompressed_offset = chunk_end;
+		offset += chunk.compressed_size;
+
+		//Only chunks which overlap range are read
+		if (chunk_end <= range_begin || chunk_end == chunk_begin)
 		{
-			success = false;
+			continue;
 		}
-		else
+
+		if (chunk_begin >= range_end)
 		{
-			success = true;
-			std::tie(sizeC, sizeU, entropy, entropy2, avg_length, level) = x.value();
+			break;
 		}
 
-		if (!success)
+		auto job = std::make_unique<Job>();
+		job->size = chunk.uncompressed_size;
+
+		if (!file_IO.readAt(offset - chunk.compressed_size, chunk.compressed_size, job->input))
 		{
-			std::cout << "Oh, no. Something went wrong\n";
-			return 0;
+			success = false;
+			break;
 		}
 
-		std::cout << "Compressed file emtropy: " << entropy2 << "\n";
-		std::cout << "Compressed file size: " << sizeC << "\n";
-		std::cout << "Uncompressed file emtropy: " << entropy << "\n";
-		std::cout << "Uncompressed file size: " << sizeU << "\n";
-		std::cout << "Arg codeword length: " << avg_length << "\n";
-		std::cout << "CR: " << level << "\n";
-	}
-	else if (job == "decode")
-	{
-		//DictionaryHashTableHelper::fast faster encoding, great for big files, terrible for small
-		//DictionaryHashTableHelper::slow slower encoding, terrible for big files, good for small
-		auto decoder = getDecodeFunction<DictionaryHashTableHelper::slow>(numbers_coding);
+		auto skip = std::max(range_begin, chunk_begin) - chunk_begin;
+		auto count = std::min(range_end, chunk_end) - chunk_begin - skip;
 
-		auto x = decoder(input_file, output_file);
+		pending.push_back({ job->result.get_future(), skip, count });
+		jobs.push(std::move(job));
 
-		if (!x)
+		if (pending.size() >= 2 * threads)
 		{
-			std::cout << "Oh, no. Something went wrong\n";
-			return 0;
+			writeChunk();
+		}
+
+		if (!success)
+		{
+			break;
 		}
 	}
-	else
+
+	while (!pending.empty())
 	{
-		std::cout << "Invalid job\n";
-		return 0;
+		writeChunk();
 	}
 
-	return 0;
-}
+	for (std::size_t i = 0; i < workers.size(); i++)
+	{
+		jobs.push(nullptr);
+	}
 
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
 
-bool checkFiles(std::string_view input_file, std::string_view output_file)
-{
-	return input_file != output_file;
+	return success && file_IO.finish();
 }
 
-class FileIO
+//Every worker codes whole files with one dictionary, it is only cleared between files
+template <typename NC, typename SPEED>
+bool codeBatch(const std::vector<std::filesystem::path>& inputs, const std::vector<std::filesystem::path>& outputs, const CodingOptions& options)
 {
-public:
-	FileIO(std::string_view input_file, std::string_view output_file) {
-		input.open(input_file.data(), std::ios_base::in | std::ios_base::binary);
-		output.open(output_file.data(), std::ios_base::out | std::ios_base::binary);
+	//Files are whole streams without index, and there is no single stream to snapshot
+	if (options.seekable || !options.snapshot_file.empty() || !presetFits<SPEED>(options, baseSize(options)))
+	{
+		return false;
 	}
-	FileIO(const FileIO&) = delete;
-	FileIO(FileIO&&) = delete;
-	FileIO& operator=(const FileIO&) = delete;
-	FileIO& operator=(FileIO&&) = delete;
 
-	~FileIO() {
-		input.close();
-		output.close();
+	auto threads = options.threads ? options.threads : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+	//Next file to code
+	std::atomic<std::size_t> next{};
+	std::atomic<std::uint64_t> loaded{};
+	std::atomic<std::uint64_t> saved{};
+	std::atomic<std::size_t> failed{};
+
+	//Time of every file, written only by its worker, negative for failed file
+	std::vector<double> latencies(inputs.size(), -1);
+
+	//Dictionaries only have to be big enough for largest file
+	std::uint64_t largest{};
+
+	for (auto& input : inputs)
+	{
+		std::error_code error{};
+		largest = std::max<std::uint64_t>(largest, std::filesystem::file_size(input, error));
 	}
 
-	bool isValid() const { return input && output; }
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers{};
 
-	template <typename T>
-	bool read(std::vector<T>& data) {
-		if (!input) return false;
-		data.resize(input_size);
-		input.read(reinterpret_cast<char*>(data.data()), data.size() * sizeof(T));
-		if (!input)
+	for (std::size_t i = 0; i < threads; i++)
+	{
+		workers.emplace_back([&]
 		{
-			data.resize(input.gcount());
-		}
+			LZWEncoder<NC, SPEED> encoder{ LZWCoderHelper::fittingBaseSize<SPEED>(baseSize(options), largest, presetSize(options)), options.reset, options.preset.get() };
 
-		return true;
-	}
+			if (options.pair_table)
+			{
+				encoder.enablePairTable();
+			}
+			std::vector<unsigned char> input{};
+			BitWriter out{};
 
-	template <typename T>
-	void write(std::vector<T>& data) {
-		output.write(reinterpret_cast<char*>(data.data()), data.size() * sizeof(T));
-		data.clear();
-	}
+			for (auto index = next++; index < inputs.size(); index = next++)
+			{
+				auto file_start = std::chrono::steady_clock::now();
 
-private:
-	std::fstream input{};
-	std::fstream output{};
+				std::ifstream in{ inputs[index], std::ios_base::binary };
+				std::error_code error{};
+				input.resize(std::filesystem::file_size(inputs[index], error));
 
-	const std::size_t input_size = 100 * 1000 * 1024;
-};
+				if (error || !in.read(reinterpret_cast<char*>(input.data()), input.size()))
+				{
+					failed++;
+					continue;
+				}
 
-template <std::size_t N>
-void copyToVector(std::bitset<N>& a, std::uint64_t& sh, std::vector<unsigned char>& b, std::vector<std::uint64_t>& characters_c_count)
-{
-	unsigned long tmp;
-	std::vector<unsigned char> r_out{};
+				encoder.restart();
+				encoder.code(input.data(), input.data() + input.size(), out);
+				encoder.finish(out);
 
-	while (sh >= 8)
-	{
-		tmp = a[0] | a[1] << 1 | a[2] << 2 | a[3] << 3 | a[4] << 4 | a[5] << 5 | a[6] << 6 | a[7] << 7;
-		a >>= 8;
-		sh -= 8;
-		r_out.push_back(static_cast<unsigned char>(tmp & 0xFF));
-		characters_c_count[r_out.back()]++;
-	}
+				auto& bytes = out.flush();
 
-	std::copy(r_out.begin(), r_out.end(), std::back_inserter(b));
-}
+				std::filesystem::create_directories(outputs[index].parent_path(), error);
+				std::ofstream file{ outputs[index], std::ios_base::binary };
+				file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+				file.close();
 
-template <std::size_t N>
-void copyToBitset(std::bitset<N>& a, std::uint64_t& sh, std::vector<unsigned char>::iterator& it)
-{
-	if (sh >= 8)
-	{
-		sh -= 8;
-		a >>= 8;
-		a[N - 1] = *it & 0x80;
-		a[N - 2] = *it & 0x40;
-		a[N - 3] = *it & 0x20;
-		a[N - 4] = *it & 0x10;
-		a[N - 5] = *it & 0x08;
-		a[N - 6] = *it & 0x04;
-		a[N - 7] = *it & 0x02;
-		a[N - 8] = *it & 0x01;
+				auto size = bytes.size();
+				bytes.clear();
+
+				if (!file)
+				{
+					failed++;
+					continue;
+				}
 
+				loaded += input.size();
+				saved += size;
+
+				latencies[index] = std::chrono::duration<double>(std::chrono::steady_clock::now() - file_start).count();
+			}
+		});
 	}
 
-	++it;
-}
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
 
-template <std::size_t N>
-void fillBitset(std::bitset<N>& a, std::uint64_t& sh, bool fill)
-{
-	if (sh >= 8)
+	auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	//Failed files would distort latency, they can end at any point
+	latencies.erase(std::remove_if(latencies.begin(), latencies.end(), [](double latency) { return latency < 0; }), latencies.end());
+	std::sort(latencies.begin(), latencies.end());
+
+	auto percentile = [&](double p)
 	{
-		sh -= 8;
-		a >>= 8;
-		a[N - 1] = fill << 7;
-		a[N - 2] = fill << 6;
-		a[N - 3] = fill << 5;
-		a[N - 4] = fill << 4;
-		a[N - 5] = fill << 3;
-		a[N - 6] = fill << 2;
-		a[N - 7] = fill << 1;
-		a[N - 8] = fill;
+		return latencies.empty() ? 0.0 : latencies[static_cast<std::size_t>(p * (latencies.size() - 1))] * 1000;
+	};
 
-	}
+	std::cout << "Files: " << inputs.size() << ", failed: " << failed << "\n";
+	std::cout << "Uncompressed size: " << loaded << ", compressed size: " << saved << "\n";
+	std::cout << "Files per second: " << latencies.size() / time << ", MB/s: " << loaded / time / 1e6 << "\n";
+	std::cout << "Latency ms p50: " << percentile(0.5) << ", p99: " << percentile(0.99) << ", max: " << percentile(1) << "\n";
+
+	return failed == 0;
 }
 
-template <typename NC, typename SPEED>
-std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> code(std::string_view input_file, std::string_view output_file)
+//Input is cut to blocks of LZ77Helper::block_size, blocks are coded in order by one encoder
+template <typename NC>
+std::optional<std::tuple<std::uint64_t, std::uint64_t, double, double, double, double>> codeLZ77(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
 {
-	if (!checkFiles(input_file, output_file))
+	//Options of LZW streams don't apply
+	if (!checkFiles(input_file, output_file) || options.threads > 0 || options.seekable || options.preset || !options.snapshot_file.empty())
 	{
 		return {};
 	}
 
-	FileIO file_IO{ input_file, output_file };
+	AsyncFileIO file_IO{ input_file, output_file, options.io_mode, options.async_io };
 
 	if (!file_IO.isValid())
 	{
 		return {};
 	}
 
-	NC numbers_coding{};
-
-	//Dictionary
-	DictionaryHashTable<SPEED> DHT{ ProgramSettings::DHT_base_size };
-
-	//Input buffer
-	std::vector<unsigned char> in_buffer{};
-	auto it = in_buffer.begin();
-
-	//bitset shift
-	std::uint64_t sh{};
+	LZ77Encoder<NC> encoder{ static_cast<unsigned>(options.level) };
+	BitWriter out{};
 
-	//Output buffer
-	std::vector<unsigned char> out_b{};
+	const std::size_t max_buffer_size = file_IO.outputBufferSize();
 
-	//Output buffer for number encoding
-	std::bitset<512> out;
+	std::vector<std::uint64_t> characters_c_count(256);
+	std::vector<std::uint64_t> characters_u_count(256);
 
-	constexpr std::size_t max_buffer_size = 100 * 1000 * 1024;
+	std::uint64_t loaded{};
+	std::uint64_t saved{};
 
-	//Entropy
-	std::vector<std::uint64_t> characters_c_count{};
-	std::vector<std::uint64_t> characters_u_count{};
-	characters_u_count.resize(256);
-	characters_c_count.resize(256);
+	//Block which continues in next part of input
+	std::vector<unsigned char> block{};
+	block.reserve(LZ77Helper::block_size);
 
-	//hashed Index in dictionary
-	std::uint64_t last_index = 0;
-	std::uint64_t next_index = 0;
+	auto codeBlock = [&](const unsigned char* begin, const unsigned char* end)
+	{
+		encoder.code(begin, end, out);
+		loaded += end - begin;
 
-	//real index in dictionary
-	std::size_t last_realID = 0;
+		if (out.size() > max_buffer_size)
+		{
+			saved += dumpBits(out, file_IO, characters_c_count);
+		}
 
-	const DictionaryNode* node;
+		std::clog << loaded / 1024000 << " MB\n";
+	};
 
-	std::uint64_t loaded{};
-	std::uint64_t saved{};
+	const unsigned char* it{ nullptr };
+	const unsigned char* in_end{ nullptr };
 
 	while (true)
 	{
-		//Load input buffer from file
-		if (it == in_buffer.end())
 		{
-			if (!file_IO.read(in_buffer))
-			{
-				break;
-			}
-
-			it = in_buffer.begin();
+			LZW_STAT(PhaseTimer timer{ Stats::read });
 
-			if (it == in_buffer.end())
-			{
+			if (!file_IO.read(it, in_end))
 				break;
-			}
 		}
 
-		//get next index
-		next_index = DHT.hash(last_index, *it);
-
-		characters_u_count[*it]++;
-
-		if ((node = DHT.at(next_index, last_realID)))
+		for (auto c = it; c != in_end; c++)
 		{
-			//Node exists, continue
-
-			last_index = next_index;
-			last_realID = DHT.getNodeRealID(node);
+			characters_u_count[*c]++;
 		}
-		else
-		{
-			//Node don't exist, output last_realID
-			//and add new node
-			numbers_coding.encode(out, sh, last_realID);
-			copyToVector<>(out, sh, out_b, characters_c_count);
 
-			if (out_b.size() > max_buffer_size)
+		while (it != in_end)
+		{
+			//Whole blocks are coded directly from input part
+			if (block.empty() && static_cast<std::size_t>(in_end - it) >= LZ77Helper::block_size)
 			{
-				//dump output_buffer to file
-				saved += out_b.size();
-				file_IO.write(out_b);
+				codeBlock(it, it + LZ77Helper::block_size);
+				it += LZ77Helper::block_size;
+				continue;
 			}
 
-			if (DHT.size() < DHT.maxSize())
-			{
-				DHT.insert({ next_index, last_realID, *it });
-			}
+			auto count = std::min<std::size_t>(in_end - it, LZ77Helper::block_size - block.size());
+			block.insert(block.end(), it, it + count);
+			it += count;
 
-			if (DHT.size() >= DHT.maxSize())
+			if (block.size() == LZ77Helper::block_size)
 			{
-				//Dictionary is full
-				//Clear current dictionary for new data
-				DHT.clear();
+				codeBlock(block.data(), block.data() + block.size());
+				block.clear();
 			}
-
-			//Initialize new string with base character (ASCII: 0-255)
-			last_realID = DHT.getBaseNodeRealID(*it);
-			last_index = DHT.at(last_realID)->index;
 		}
 
-		it++;
-		loaded++;
-
-		if (loaded % 1024000 == 0)
+		if (!file_IO.isValid())
 		{
-			std::clog << loaded / 1024000 << " MB\n";
+			return {};
 		}
 	}
 
-	numbers_coding.encode(out, sh, last_realID);
-
-	//Align to 8 bit
-	while (sh % 8 != 0)
+	if (!block.empty())
 	{
-		out[sh] = numbers_coding.fill;
-		sh++;
+		codeBlock(block.data(), block.data() + block.size());
 	}
 
-	copyToVector<>(out, sh, out_b, characters_c_count);
+	saved += dumpBits(out, file_IO, characters_c_count);
 
-	saved += out_b.size();
-	file_IO.write(out_b);
+	if (!file_IO.finish())
+	{
+		return {};
+	}
 
-	//Calculate Entropy
-	std::uint64_t size_u = std::accumulate(characters_u_count.begin(), characters_u_count.end(), std::uint64_t{});
-	std::uint64_t size_c = std::accumulate(characters_c_count.begin(), characters_c_count.end(), std::uint64_t{});
-	double H_u_tmp = 1;
-	double H_c_tmp = 1;
-	for (auto&& x : characters_u_count)
+	return codingStats(saved, loaded, characters_u_count, characters_c_count);
+}
+
+template <typename NC>
+bool decodeLZ77(std::string_view input_file, std::string_view output_file, const CodingOptions& options)
+{
+	if (!checkFiles(input_file, output_file) || options.threads > 0 || options.seekable || options.range || options.preset)
 	{
-		if (x == 0) continue;
+		return false;
+	}
 
-		H_u_tmp *= std::pow(x / (double)size_u, x / (double)size_u);
+	AsyncFileIO file_IO{ input_file, output_file, options.io_mode, options.async_io };
 
+	if (!file_IO.isValid())
+	{
+		return false;
 	}
 
-	for (auto&& x : characters_c_count)
+	LZ77Decoder<NC> decoder{};
+	BitReader<AsyncFileIO> in{ file_IO };
+
+	std::vector<unsigned char> out_buffer{};
+	std::size_t out_pos{};
+
+	auto success = decoder.decode(in, out_buffer, out_pos, file_IO.outputBufferSize(), [&](std::size_t size)
 	{
-		if (x == 0) continue;
+		out_buffer.resize(size);
+		std::clog << in.consumed() / (1024000 * 8) << " MB\n";
 
-		H_c_tmp *= std::pow(x / (double)size_c, x / (double)size_c);
+		return file_IO.write(out_buffer);
+	});
 
+	if (!success)
+	{
+		return false;
 	}
 
-	double H_u = static_cast<double>(std::abs(std::log2l(H_u_tmp)));
-	double H_c = static_cast<double>(std::abs(std::log2l(H_c_tmp)));
+	out_buffer.resize(out_pos);
 
-	return { { saved, loaded, H_u, H_c, (8.0 * saved) / (double)loaded, (double)loaded / (double)saved } };
+	return file_IO.write(out_buffer) && file_IO.finish();
 }
 
-template <typename NC, typename SPEED>
-bool decode(std::string_view input_file, std::string_view output_file)
+//LZW parse of corpus with one dictionary, every file is parsed from start like separate message
+//Phrases walked through most often become preset, parent is walked at least as often as its child
+//and has smaller code, so selected phrases always have their prefixes selected too
+bool trainPreset(const std::filesystem::path& corpus, std::string_view output_file, std::size_t preset_size)
 {
-	if (!checkFiles(input_file, output_file))
+	std::vector<std::filesystem::path> files{};
+	std::error_code error{};
+	std::uint64_t total{};
+
+	if (std::filesystem::is_directory(corpus, error))
 	{
-		return false;
+		for (auto& entry : std::filesystem::recursive_directory_iterator{ corpus, error })
+		{
+			if (entry.is_regular_file())
+			{
+				files.push_back(entry.path());
+				total += entry.file_size();
+			}
+		}
+	}
+	else
+	{
+		files.push_back(corpus);
+		total = std::filesystem::file_size(corpus, error);
 	}
 
-	FileIO file_IO{ input_file, output_file };
-
-	if (!file_IO.isValid())
+	if (error)
 	{
 		return false;
 	}
 
-	NC numbers_coding{};
+	DictionaryTrie dictionary{ LZWCoderHelper::fittingBaseSize<DictionaryHashTableHelper::trie>(ProgramSettings::DHT_base_size, total) };
+	std::vector<std::uint64_t> visits(dictionary.maxSize() + 1);
+	std::vector<unsigned char> input{};
+
+	for (auto& file : files)
+	{
+		std::ifstream in{ file, std::ios_base::binary };
+		input.assign(std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{});
 
-	//Dictionary
-	DictionaryHashTable<SPEED> DHT{ ProgramSettings::DHT_base_size };
+		if (input.empty())
+			continue;
 
-	//Input buffer
-	std::vector<unsigned char> in_b{};
-	auto it = in_b.begin();
+		auto current = dictionary.getBaseNodeRealID(input[0]);
+
+		for (std::size_t i = 1; i < input.size(); i++)
+		{
+			if (auto node = dictionary.at(current, input[i]))
+			{
+				current = dictionary.getNodeRealID(node);
+				visits[current]++;
+				continue;
+			}
 
-	//Number deencoder buffer
-	std::bitset<512> in; //Important in_b.size() >= in.size()!!
+			if (dictionary.size() < dictionary.maxSize())
+			{
+				dictionary.insert({ static_cast<std::uint32_t>(current), input[i] });
+			}
 
-	//Bitset shift
-	std::uint64_t sh{ in.size() };
+			current = dictionary.getBaseNodeRealID(input[i]);
+		}
+	}
 
-	//If all data is read, set it false
-	bool continue_reading{ true };
+	//Phrases which were never extended or matched again don't help
+	std::vector<std::uint32_t> selected{};
 
-	//Output buffer
-	std::vector<unsigned char> out_buffer{};
+	for (std::size_t code = PresetDictionary::first_code; code <= dictionary.size(); code++)
+	{
+		if (visits[code])
+		{
+			selected.push_back(static_cast<std::uint32_t>(code));
+		}
+	}
 
-	constexpr std::size_t max_buffer_size = 100 * 1000 * 1024;
+	auto count = std::min(preset_size, selected.size());
 
-	//hash index an real index
-	std::size_t last_realID = 0;
-	std::size_t last_index = 0;
-	std::size_t next_realID = 0;
-	std::size_t next_index = 0;
+	std::partial_sort(selected.begin(), selected.begin() + count, selected.end(), [&visits](std::uint32_t a, std::uint32_t b)
+	{
+		return visits[a] != visits[b] ? visits[a] > visits[b] : a < b;
+	});
 
-	auto tmp = next_realID;
-	std::vector<unsigned char> to_append{};
+	selected.resize(count);
+	std::sort(selected.begin(), selected.end());
 
-	std::uint64_t loaded{ 0 };
-	std::uint64_t load_level{ 1024000 * 8 };
-	std::uint64_t saved{ 0 };
+	//Phrases get new codes in the same order, parents keep smaller codes
+	std::vector<std::uint32_t> new_codes(dictionary.size() + 1);
+	std::vector<std::pair<std::uint32_t, unsigned char>> phrases{};
 
-	//get data from file
-	if (it == in_b.end())
+	for (auto code : selected)
 	{
-		file_IO.read(in_b);
+		auto node = dictionary.at(code);
+		auto parent = node->parent < PresetDictionary::first_code ? node->parent : new_codes[node->parent];
 
-		it = in_b.begin();
+		new_codes[code] = static_cast<std::uint32_t>(PresetDictionary::first_code + phrases.size());
+		phrases.push_back({ parent, node->character });
 	}
 
-	if (it == in_b.end())
+	std::cout << "Preset phrases: " << phrases.size() << " of " << dictionary.size() - DictionaryHashTableHelper::clear_code << "\n";
+
+	return PresetDictionary::save(std::string{ output_file }, phrases);
+}
+
+template <typename NC>
+void benchmarkCoder(std::string_view name, const std::vector<std::uint64_t>& values)
+{
+	NC numbers_coding{};
+	BitWriter out{};
+
+	//Values have at most 24 bits
+	LZWCoderHelper::setMaxCode(numbers_coding, (1ull << 24) - 1);
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (auto x : values)
 	{
-		return true;
+		numbers_coding.encode(out, x);
 	}
 
-	while (sh > 0 && it != in_b.end())
+	helper::align(numbers_coding, out);
+
+	auto encoded = std::chrono::steady_clock::now();
+
+	//Same codes through emit stage of encoder, output has to be the same
+	BitWriter batch_out{};
+	LZWCoderHelper::EmitBatch<NC> batch{};
+
+	for (auto x : values)
 	{
-		copyToBitset(in, sh, it);
+		batch.push(x, (1ull << 24) - 1);
+
+		if (batch.full())
+		{
+			batch.emit(numbers_coding, batch_out);
+		}
 	}
 
-	//Bitset always have to be full(sh < 8), so fill with fill bit
-	while (sh > 0)
+	batch.emit(numbers_coding, batch_out);
+	helper::align(numbers_coding, batch_out);
+
+	auto batched = std::chrono::steady_clock::now();
+
+	auto& bytes = out.flush();
+	MemoryInput memory{ bytes.data(), bytes.data() + bytes.size() };
+	BitReader<MemoryInput> in{ memory };
+	std::size_t errors{};
+
+	for (auto x : values)
 	{
-		fillBitset(in, sh, numbers_coding.fill);
+		auto value = numbers_coding.decode(in);
+		errors += !value.second || value.first != x;
 	}
 
-	last_index = next_index;
+	auto decoded = std::chrono::steady_clock::now();
 
-	//Calculate new bitset shift
-	auto sh_c = sh;
-	//new real index to save
-	last_realID = numbers_coding.decode(in, sh).first;
-	loaded += sh - sh_c;
+	auto encode_time = std::chrono::duration<double>(encoded - start).count();
+	auto batch_time = std::chrono::duration<double>(batched - encoded).count();
+	auto decode_time = std::chrono::duration<double>(decoded - batched).count();
 
-	tmp = last_realID;
-	
-	last_index = DHT.at(last_realID)->index;
+	errors += batch_out.flush() != bytes;
 
-	out_buffer.push_back(DHT.at(last_realID)->character);
+	std::cout << name << ": encode " << values.size() / encode_time / 1e6 << " Mcodes/s, batched " << values.size() / batch_time / 1e6 << " Mcodes/s, decode "
+		<< values.size() / decode_time / 1e6 << " Mcodes/s, " << 8.0 * bytes.size() / values.size() << " bits/code";
 
-	while (true)
+	if (errors)
 	{
-		//Write data to input buffer an bitset
-		while (sh >= 8)
-		{
-			if (!continue_reading)
-			{
-				while (sh >= 8)
-				{
-					fillBitset(in, sh, numbers_coding.fill);
-				}
-			}
-			else
-			{
-				while (sh >= 8 && it != in_b.end())
-				{
-					copyToBitset(in, sh, it);
-				}
+		std::cout << ", " << errors << " errors";
+	}
 
-				if (it == in_b.end())
-				{
-					if (!file_IO.read(in_b))
-					{
-						break;
-					}
+	std::cout << "\n";
+}
 
-					it = in_b.begin();
+void benchmarkCoders(std::size_t count)
+{
+	//Dictionary indexes, length of index is uniform in 1-24 bits
+	std::mt19937_64 rnd{ 2023 };
+	std::vector<std::uint64_t> values(count);
 
-					if (it == in_b.end())
-					{
-						continue_reading = false;
-					}
-				}
-			}
-		}
+	for (auto& x : values)
+	{
+		auto size = 1 + rnd() % 24;
+		x = (rnd() >> (64 - size)) | (1ull << (size - 1));
+	}
 
-		//Calculate new bitset shift
-		sh_c = sh;
-		//new real index to save
-		auto next = numbers_coding.decode(in, sh);
-		loaded += sh - sh_c;
+	benchmarkCoder<NumbersCoder<E_gamma>>("gamma", values);
+	benchmarkCoder<NumbersCoder<E_delta>>("delta", values);
+	benchmarkCoder<NumbersCoder<E_omega>>("omega", values);
+	benchmarkCoder<NumbersCoder<fib>>("fib", values);
+	benchmarkCoder<NumbersCoder<binary>>("binary", values);
+	benchmarkCoder<NumbersCoder<blockwise>>("auto", values);
+}
 
-		if (!next.second)
-		{
-			//Number encoder returned false, so there aren't any numbers in buffer
-			break;
-		}
+template <typename SPEED, typename HASH>
+void benchmarkHash(std::string_view dictionary, std::string_view name, const std::vector<unsigned char>& input, const CodingOptions& options)
+{
+	//Binary codes are the cheapest, so time is mostly time of dictionary
+	LZWEncoder<NumbersCoder<binary>, SPEED, HASH> encoder{ LZWCoderHelper::fittingBaseSize<SPEED>(baseSize(options), input.size()), options.reset };
+	BitWriter out{};
 
-		next_realID = next.first;
+	auto start = std::chrono::steady_clock::now();
 
-		if (DHT.at(next_realID)->index == 0)
-		{
-			//If coder returned unknow index, so it must be last string extended by first character
-			//Append first character
-			auto new_index = DHT.hash(last_index, DHT.at(tmp)->character);
-			DHT.insert({ new_index, last_realID, DHT.at(tmp)->character });
-		}
+	encoder.code(input.data(), input.data() + input.size(), out);
+	encoder.finish(out);
 
-		//Read all character in list created by first node
-		tmp = next_realID;
-		to_append.clear();
-		for (;;)
-		{
-			to_append.push_back(DHT.at(tmp)->character);
+	auto time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 
-			if (!DHT.at(tmp)->parent)
-				break;
+	//Probes of nodes in dictionary after last clear
+	constexpr std::size_t max_probe = 8;
+	auto lengths = encoder.getDictionary().probeLengths(max_probe);
+	auto nodes = std::accumulate(lengths.begin(), lengths.end(), std::uint64_t{});
+	std::uint64_t probes{};
 
-			tmp = DHT.at(tmp)->parent;
-		}
-		//String is reversed, so copry with reverse iterrators
-		std::copy(to_append.rbegin(), to_append.rend(), std::back_inserter(out_buffer));
+	for (std::size_t i = 0; i < lengths.size(); i++)
+	{
+		probes += (i + 1) * lengths[i];
+	}
 
-		if (out_buffer.size() > max_buffer_size)
-		{
-			//Save output buffer to file
-			saved += out_buffer.size();
-			file_IO.write(out_buffer);
-		}
+	std::cout << dictionary << " " << name << ": " << input.size() / time / 1e6 << " MB/s, " << out.written() / 8 << " bytes, mean probes " << static_cast<double>(probes) / nodes << ", probes";
+
+	for (std::size_t i = 0; i < lengths.size(); i++)
+	{
+		std::cout << " " << i + 1 << (i + 1 == max_probe ? "+" : "") << ": " << 100.0 * lengths[i] / nodes << "%";
+	}
 
-		//Calcuate index for new string
-		//Connect last string, with first character from next string
-		next_index = DHT.hash(last_index, DHT.at(tmp)->character);
+	std::cout << "\n";
+}
 
-		if (DHT.size() < DHT.maxSize())
-		{
-			DHT.insert({ next_index, last_realID, DHT.at(tmp)->character });
-		}
+template <typename SPEED>
+void benchmarkHashes(std::string_view dictionary, const std::vector<unsigned char>& input, const CodingOptions& options)
+{
+	//Linear probing with additive hash takes hours for big input, group probing stays usable
+	if constexpr (std::is_same_v<SPEED, DictionaryHashTableHelper::swiss>)
+	{
+		benchmarkHash<SPEED, DictionaryHashTableHelper::additive>(dictionary, "additive", input, options);
+	}
 
-		if (DHT.size() >= DHT.maxSize())
-		{
-			//Dictionary is full
-				//Clear current dictionary for new data
-			DHT.clear();
-		}
+	benchmarkHash<SPEED, DictionaryHashTableHelper::combine>(dictionary, "combine", input, options);
+	benchmarkHash<SPEED, DictionaryHashTableHelper::fibonacci>(dictionary, "fibonacci", input, options);
+	benchmarkHash<SPEED, DictionaryHashTableHelper::crc32c>(dictionary, "crc32c", input, options);
+	benchmarkHash<SPEED, DictionaryHashTableHelper::wyhash>(dictionary, "wyhash", input, options);
+}
 
-		last_realID = next_realID;
-		last_index = DHT.at(last_realID)->index;
-		
+//Every policy codes the same input, output size has to be the same for all of them
+bool benchmarkHashes(const std::string& corpus, const CodingOptions& options)
+{
+	std::ifstream in{ corpus, std::ios_base::binary };
+	std::vector<unsigned char> input{ std::istreambuf_iterator<char>{ in }, std::istreambuf_iterator<char>{} };
 
-		if (loaded >= load_level)
-		{
-			std::clog << loaded / (1024000 * 8) << " MB\n";
-			load_level += 1024000 * 8;
-		}
-	}
+	if (!in && !in.eof())
+		return false;
 
-	saved += out_buffer.size();
-	file_IO.write(out_buffer);
+	benchmarkHashes<DictionaryHashTableHelper::fast>("fast", input, options);
+	benchmarkHashes<DictionaryHashTableHelper::swiss>("swiss", input, options);
 
 	return true;
 }
@@ -3,8 +3,10 @@
 #include <type_traits>
 #include <cstdint>
 #include <array>
-#include <bitset>
 #include <vector>
+#include <algorithm>
+
+#include "BitIO.h"
 
 namespace helper
 {
@@ -58,6 +60,129 @@ namespace helper
 
 	constexpr NumberSize number_size{};
 
+	//Binary length using lzcnt
+	inline std::uint32_t bitLength(std::uint64_t val)
+	{
+		return val ? 64 - BitIOHelper::countLeadingZeros(val) : 0;
+	}
+
+	//Precomputed codes for small values
+	struct SmallCode
+	{
+		std::uint32_t bits{};
+		std::uint32_t length{};
+	};
+
+	constexpr std::size_t small_codes_size = 1024;
+
+	struct OmegaPrefix
+	{
+		//Result of decoding groups which fit in first bits of code
+		struct Entry
+		{
+			std::uint8_t length{};
+			std::uint8_t value{};
+			bool done{};
+		};
+
+		static constexpr std::uint32_t bits = 11;
+		std::array<Entry, 1 << bits> entries{};
+
+		constexpr OmegaPrefix()
+		{
+			for (std::uint32_t x = 0; x < entries.size(); x++)
+			{
+				std::uint32_t pos{};
+				std::uint32_t n{ 1 };
+				bool done{ false };
+
+				while (pos < bits)
+				{
+					if (((x >> (bits - 1 - pos)) & 1) == 0)
+					{
+						done = true;
+						pos++;
+						break;
+					}
+
+					if (pos + n + 1 > bits)
+						break;
+
+					auto group = (x >> (bits - pos - (n + 1))) & ((1u << (n + 1)) - 1);
+					pos += n + 1;
+					n = group;
+				}
+
+				entries[x].length = static_cast<std::uint8_t>(pos);
+				entries[x].value = static_cast<std::uint8_t>(n);
+				entries[x].done = done;
+			}
+		}
+	};
+
+	constexpr OmegaPrefix omega_prefix{};
+
+	struct FibDecoder
+	{
+		//Fibonacci code read byte at a time, last_one says if previous byte ended with 1
+		struct Entry
+		{
+			std::uint8_t sum1{};
+			std::uint8_t sum2{};
+			std::uint8_t length{};
+			bool end{};
+			bool last_one{};
+		};
+
+		//fib[0] = 0, fib[1] = 1, ..., overflows after 93
+		std::array<std::uint64_t, 100> fib{};
+		std::array<std::array<Entry, 256>, 2> entries{};
+
+		constexpr FibDecoder()
+		{
+			fib[1] = 1;
+			for (std::size_t i = 2; i < fib.size(); i++)
+			{
+				fib[i] = fib[i - 1] + fib[i - 2];
+			}
+
+			for (std::size_t prev = 0; prev < 2; prev++)
+			{
+				for (std::uint32_t x = 0; x < 256; x++)
+				{
+					auto& entry = entries[prev][x];
+					bool last = prev;
+
+					entry.length = 8;
+
+					for (std::uint32_t t = 0; t < 8; t++)
+					{
+						bool bit = (x >> (7 - t)) & 1;
+
+						if (bit && last)
+						{
+							entry.end = true;
+							entry.length = static_cast<std::uint8_t>(t + 1);
+							break;
+						}
+
+						if (bit)
+						{
+							entry.sum1 += static_cast<std::uint8_t>(fib[t + 1]);
+							entry.sum2 += static_cast<std::uint8_t>(fib[t + 2]);
+						}
+
+						last = bit;
+					}
+
+					entry.last_one = last;
+				}
+			}
+		}
+	};
+
+	constexpr FibDecoder fib_decoder{};
+
 	template<std::size_t N>
 	constexpr void fib(std::array<std::uint64_t, N>& arr, int k)
 	{
@@ -70,6 +195,96 @@ namespace helper
 			arr[i] = arr[i - 1] + arr[i - 2];
 		}
 	}
+
+	struct OmegaEncoder
+	{
+		std::array<SmallCode, small_codes_size> small{};
+
+		constexpr OmegaEncoder()
+		{
+			for (std::uint64_t i = 1; i < small.size(); i++)
+			{
+				//Groups are added in front of previous ones, code ends with 0
+				std::uint64_t value = i;
+				std::uint32_t bits{};
+				std::uint32_t length{ 1 };
+
+				while (value > 1)
+				{
+					std::uint32_t size = number_size.getSize(value);
+					bits |= static_cast<std::uint32_t>(value) << length;
+					length += size;
+					value = size - 1;
+				}
+
+				small[i] = { bits, length };
+			}
+		}
+	};
+
+	constexpr OmegaEncoder omega_encoder{};
+
+	struct FibEncoder
+	{
+		//Fibonacci numbers which fit in 64 bits
+		std::array<std::uint64_t, 92> table{};
+
+		//Largest i with table[i] <= 2^(s - 1)
+		std::array<std::uint32_t, 65> by_size{};
+
+		std::array<SmallCode, small_codes_size> small{};
+
+		constexpr FibEncoder()
+		{
+			fib<>(table, 92);
+
+			for (std::uint32_t s = 1; s < by_size.size(); s++)
+			{
+				auto min_value = 1ull << (s - 1);
+
+				while (by_size[s] + 1 < table.size() && table[by_size[s] + 1] <= min_value)
+				{
+					by_size[s]++;
+				}
+
+				if (s + 1 < by_size.size())
+					by_size[s + 1] = by_size[s];
+			}
+
+			for (std::uint64_t i = 1; i < small.size(); i++)
+			{
+				auto top = largest(i, number_size.getSize(i));
+				std::uint32_t length = top + 2;
+				std::uint32_t bits = 1;
+				auto value = i;
+
+				//Digit j is at position length - 1 - j, last bit is terminating 1
+				while (value)
+				{
+					auto j = largest(value, number_size.getSize(value));
+					bits |= 1u << (length - 1 - j);
+					value -= table[j];
+				}
+
+				small[i] = { bits, length };
+			}
+		}
+
+		//Largest i with table[i] <= value, size is binary length of value
+		constexpr std::uint32_t largest(std::uint64_t value, std::uint32_t size) const
+		{
+			auto i = by_size[size];
+
+			while (i + 1 < table.size() && table[i + 1] <= value)
+			{
+				i++;
+			}
+
+			return i;
+		}
+	};
+
+	constexpr FibEncoder fib_encoder{};
 }
 
 
@@ -77,6 +292,9 @@ using E_gamma = std::integral_constant<int, 1>;
 using E_delta = std::integral_constant<int, 2>;
 using E_omega = std::integral_constant<int, 3>;
 using fib = std::integral_constant<int, 4>;
+using binary = std::integral_constant<int, 5>;
+//Gamma, delta, omega or fib chosen for every block of codes
+using blockwise = std::integral_constant<int, 6>;
 
 template<typename T>
 struct NumbersCoder
@@ -87,59 +305,39 @@ struct NumbersCoder
 template<>
 struct NumbersCoder<E_gamma> 
 {
-	template<std::size_t N>
-	bool encode(std::bitset<N>& data, std::uint64_t& sh, std::uint64_t value)
+	Codeword codeword(std::uint64_t value) const
 	{
-		std::uint64_t size = helper::number_size.getSize(value);
-		auto zero_count = size - 1;
-
-		if (zero_count + size + sh > N)
-			return false;
+		//size - 1 zeros and value, value has leading 1
+		return { 0, value, 2 * helper::bitLength(value) - 1 };
+	}
 
-		while (zero_count --> 0)
+	//Codewords of values which are not 0, loop has no branches, so compiler can vectorize it
+	void codewords(const std::uint32_t* values, std::uint64_t* words, std::uint32_t* lengths, std::size_t size) const
+	{
+		for (std::size_t i = 0; i < size; i++)
 		{
-			data[sh] = 0;
-			sh++;
+			words[i] = values[i];
+			lengths[i] = 2 * (64 - BitIOHelper::countLeadingZeros(values[i])) - 1;
 		}
+	}
 
-		std::uint64_t curr_sh = 1ull << (size - 1);
-		while (size --> 0)
-		{
-			data[sh] = value & curr_sh;
-			curr_sh >>= 1;
-			sh++;
-		}
+	bool encode(BitWriter& writer, std::uint64_t value)
+	{
+		writer.write(codeword(value));
 
 		return true;
 	}
 
-	template<std::size_t N>
-	std::pair<std::uint64_t, bool> decode(std::bitset<N>& data, std::uint64_t& sh)
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
 	{
-		std::size_t size{ 0 };
-		auto l_sh = sh;
-
-		while (l_sh < data.size() && data[l_sh] == 0)
-		{
-			size++;
-			++l_sh;
-		}
-
-		if (l_sh >= data.size())
-			return { 0, false };
+		//Number of zeros is length of value - 1
+		std::uint32_t zeros{};
+		std::uint64_t value{};
 
-		if (data.size() - l_sh < size + 1)
+		if (!reader.readZeros(zeros) || zeros > 63 || !reader.read(zeros + 1, value))
 			return { 0, false };
 
-		std::uint64_t value{ 0 };
-
-		for (std::size_t i = 0; i <= size; i++, l_sh++)
-		{
-			value <<= 1;
-			value |= data[l_sh];
-		}
-
-		sh = l_sh;
 		return { value, true };
 	}
 
@@ -149,313 +347,456 @@ struct NumbersCoder<E_gamma>
 template<>
 struct NumbersCoder<E_delta>
 {
-	template<std::size_t N>
-	bool encode(std::bitset<N>& data, std::uint64_t& sh, std::uint64_t value)
+	Codeword codeword(std::uint64_t value) const
 	{
-		std::uint64_t size_val = helper::number_size.getSize(value);
-		std::uint64_t size_n = helper::number_size.getSize(size_val);
-		auto zero_count = size_n - 1;
+		std::uint32_t size_val = helper::bitLength(value);
+		std::uint32_t size_n = helper::bitLength(size_val);
 
-		if (zero_count + size_val + size_n - 1 + sh > N)
-			return false;
+		//Gamma code of size_val and value without leading 1
+		auto shift = size_val - 1;
+		Codeword code{};
+		code.low = (static_cast<std::uint64_t>(size_val) << shift) | (value & ((1ull << shift) - 1));
+		code.high = shift ? static_cast<std::uint64_t>(size_val) >> (64 - shift) : 0;
+		code.length = 2 * size_n - 1 + shift;
 
-		while (zero_count --> 0)
-		{
-			data[sh] = 0;
-			sh++;
-		}
+		return code;
+	}
 
-		std::uint64_t curr_sh = 1ull << (size_n - 1);
-		while (size_n --> 0)
+	//Codewords of values which are not 0, loop has no branches, so compiler can vectorize it
+	//Values have 32 bits, so codeword is in low word and leading 1 is removed in 32 bits
+	void codewords(const std::uint32_t* values, std::uint64_t* words, std::uint32_t* lengths, std::size_t size) const
+	{
+		for (std::size_t i = 0; i < size; i++)
 		{
-			data[sh] = size_val & curr_sh;
-			curr_sh >>= 1;
-			sh++;
-		}
+			std::uint32_t size_val = 64 - BitIOHelper::countLeadingZeros(values[i]);
+			std::uint32_t size_n = 64 - BitIOHelper::countLeadingZeros(size_val);
+			auto shift = size_val - 1;
 
-		curr_sh = 1ull << (size_val - 2);
-		size_val--;
-		while (size_val --> 0)
-		{
-			data[sh] = value & curr_sh;
-			curr_sh >>= 1;
-			sh++;
+			words[i] = (static_cast<std::uint64_t>(size_val) << shift) | (values[i] ^ (1u << shift));
+			lengths[i] = 2 * size_n - 1 + shift;
 		}
+	}
+
+	bool encode(BitWriter& writer, std::uint64_t value)
+	{
+		writer.write(codeword(value));
 
 		return true;
 	}
 
-	template<std::size_t N>
-	std::pair<std::uint64_t, bool> decode(std::bitset<N>& data, std::uint64_t& sh)
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
 	{
-		std::size_t size_n{ 0 };
-		auto l_sh = sh;
-
-		while (l_sh < data.size() && data[l_sh] == 0)
-		{
-			size_n++;
-			++l_sh;
-		}
+		//Gamma coded length and value without leading 1
+		std::uint32_t zeros{};
+		std::uint64_t size_val{};
+		std::uint64_t value{};
 
-		if (l_sh >= data.size())
+		if (!reader.readZeros(zeros) || zeros > 6 || !reader.read(zeros + 1, size_val))
 			return { 0, false };
 
-		if (data.size() - l_sh < size_n + 1)
+		if (size_val > 64 || !reader.read(static_cast<std::uint32_t>(size_val) - 1, value))
 			return { 0, false };
 
-		std::uint64_t size_val{ 0 };
+		return { value | (1ull << (size_val - 1)), true };
+	}
 
-		for (std::size_t i = 0; i <= size_n; i++, l_sh++)
+	const char fill = 0;
+};
+
+template<>
+struct NumbersCoder<E_omega>
+{
+	Codeword codeword(std::uint64_t value) const
+	{
+		if (value < helper::small_codes_size)
 		{
-			size_val <<= 1;
-			size_val |= data[l_sh];
+			auto& small = helper::omega_encoder.small[value];
+			return { 0, small.bits, small.length };
 		}
 
-		if (data.size() - l_sh < --size_val)
-			return { 0, false };
+		//Code of size - 1 without its ending 0, value and 0
+		std::uint32_t size = helper::bitLength(value);
+		auto& prefix = helper::omega_encoder.small[size - 1];
+		std::uint64_t prefix_bits = prefix.bits >> 1;
+		auto shift = size + 1;
 
-		std::uint64_t value{ 1 };
+		Codeword code{};
+		code.length = prefix.length - 1 + shift;
 
-		for (std::size_t i = 0; i < size_val; i++, l_sh++)
+		if (shift < 64)
 		{
-			value <<= 1;
-			value |= data[l_sh];
+			code.low = (prefix_bits << shift) | (value << 1);
+			code.high = prefix_bits >> (64 - shift);
+		}
+		else
+		{
+			code.low = value << 1;
+			code.high = shift == 64 ? prefix_bits : (prefix_bits << 1) | (value >> 63);
 		}
 
-		sh = l_sh;
-
-		return { value, true };
+		return code;
 	}
 
-	const char fill = 0;
-};
-
-template<>
-struct NumbersCoder<E_omega>
-{
-	NumbersCoder()
+	bool encode(BitWriter& writer, std::uint64_t value)
 	{
-		tmp.reserve(1024);
+		writer.write(codeword(value));
+
+		return true;
 	}
 
-	template<std::size_t N>
-	bool encode(std::bitset<N>& data, std::uint64_t& sh, std::uint64_t value)
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
 	{
-		tmp.clear();
-		auto it = std::back_inserter(tmp);
-		std::uint64_t curr_sh{};
-		std::uint64_t size{}, size_c{};
+		//First groups are decoded with one lookup
+		reader.ensure(helper::OmegaPrefix::bits);
+		auto& entry = helper::omega_prefix.entries[reader.peek(helper::OmegaPrefix::bits)];
+
+		if (entry.length > reader.available())
+			return { 0, false };
 
-		while (value > 1)
+		reader.skip(entry.length);
+		std::uint64_t value = entry.value;
+
+		if (entry.done)
+			return { value, true };
+
+		for (;;)
 		{
-			size_c = size = helper::number_size.getSize(value);
-			curr_sh = 1;
+			if (!reader.ensure(1))
+				return { 0, false };
 
-			while (size --> 0)
+			if (reader.peek(1) == 0)
 			{
-				*it = static_cast<bool>(value & curr_sh);
-				curr_sh <<= 1;
-				it++;
+				reader.skip(1);
+				return { value, true };
 			}
 
-			value = size_c - 1;
+			if (value > 63 || !reader.read(static_cast<std::uint32_t>(value) + 1, value))
+				return { 0, false };
 		}
+	}
 
-		std::reverse(tmp.begin(), tmp.end());
-		tmp.push_back(0);
+	const char fill = 1;
+};
 
-		if (tmp.size() + sh > N)
-			return false;
+template<>
+struct NumbersCoder<fib>
+{
+	Codeword codeword(std::uint64_t value) const
+	{
+		auto& encoder = helper::fib_encoder;
 
-		for (auto&& x : tmp)
+		if (value < helper::small_codes_size)
 		{
-			data[sh] = x;
-			++sh;
+			auto& small = encoder.small[value];
+			return { 0, small.bits, small.length };
 		}
 
-		return true;
-	}
+		//Greedy Zeckendorf representation, digit i is at position length - 1 - i
+		auto top = encoder.largest(value, helper::bitLength(value));
+		Codeword code{};
+		code.length = top + 2;
+		code.low = 1;
 
-	template<std::size_t N>
-	std::pair<std::uint64_t, bool> decode(std::bitset<N>& data, std::uint64_t& sh)
-	{
-		if (sh != N)
+		while (value >= helper::small_codes_size)
+		{
+			auto i = encoder.largest(value, helper::bitLength(value));
+			auto position = code.length - 1 - i;
+
+			if (position < 64)
+				code.low |= 1ull << position;
+			else
+				code.high |= 1ull << (position - 64);
+
+			value -= encoder.table[i];
+		}
+
+		if (value)
 		{
-			if (data[sh] == 0)
+			//Rest of digits from small code, without its terminating 1
+			auto& small = encoder.small[value];
+			std::uint64_t bits = small.bits >> 1;
+			auto shift = code.length - small.length + 1;
+
+			if (shift < 64)
 			{
-				sh++;
-				return { 1, true };
+				code.low |= bits << shift;
+				code.high |= shift ? bits >> (64 - shift) : 0;
+			}
+			else
+			{
+				code.high |= bits << (shift - 64);
 			}
 		}
 
-		auto l_sh = sh;
-		std::uint64_t to_read = 2;
+		return code;
+	}
+
+	bool encode(BitWriter& writer, std::uint64_t value)
+	{
+		if (value == 0)
+			return false;
+
+		writer.write(codeword(value));
+
+		return true;
+	}
+
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
+	{
 		std::uint64_t value{};
+		bool last_one{ false };
 
-		for (;;)
+		//Code has at most 93 bits
+		for (std::size_t i = 0; i < 12; i++)
 		{
-			if (to_read + l_sh > N)
+			reader.ensure(8);
+			auto& entry = helper::fib_decoder.entries[last_one][reader.peek(8)];
+
+			if (entry.length > reader.available())
 				return { 0, false };
 
-			while (to_read-- > 0)
-			{
-				value <<= 1;
-				value |= data[l_sh++];
-			}
+			reader.skip(entry.length);
 
-			if (l_sh == N)
-				return { 0, false };
+			//F(8i + t + 2) = F(8i + 1) * F(t + 2) + F(8i) * F(t + 1)
+			value += helper::fib_decoder.fib[8 * i + 1] * entry.sum2 + helper::fib_decoder.fib[8 * i] * entry.sum1;
 
-			if (data[l_sh] == 0)
-			{
-				sh = l_sh + 1;
+			if (entry.end)
 				return { value, true };
-			}
 
-			to_read = value + 1;
-			value = 0;
+			last_one = entry.last_one;
 		}
 
 		return { 0, false };
 	}
 
-	const char fill = 1;
-
-private:
-	std::vector<char> tmp{};
+	const char fill = 0;
 };
 
+//Fixed width code, width is length of largest possible value
+//LZW coder and decoder both know dictionary size, so width grows with dictionary
 template<>
-struct NumbersCoder<fib>
+struct NumbersCoder<binary>
 {
-	constexpr NumbersCoder()
+	//Has to be called before encode and decode
+	void setMaxValue(std::uint64_t value)
 	{
-		helper::fib<>(fib_table, 93);
+		width = helper::bitLength(value);
 	}
 
-	template<std::size_t N>
-	bool encode(std::bitset<N>& data, std::uint64_t& sh, std::uint64_t value)
+	Codeword codeword(std::uint64_t value) const
 	{
-		tmp.reset();
-		tmp[0] = 1;
+		return { 0, value, width };
+	}
 
-		auto l_sh = 1;
-		auto curr = bsearch(value, 0, 92);
-		decltype(curr) next{};
+	bool encode(BitWriter& writer, std::uint64_t value)
+	{
+		if (width < 64 && (value >> width) != 0)
+			return false;
 
-		while (value)
-		{
-			tmp <<= 1;
-			tmp[0] = 1;
-			l_sh++;
+		writer.write(value, width);
 
-			value -= fib_table[curr];
-			if (value == 0)
-			{
-				break;
-			}
+		return true;
+	}
 
-			//binary search for next fibonacci number
-			next = bsearch(value, 0, curr);
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
+	{
+		//Padding is shorter than byte, so it never forms whole code
+		std::uint64_t value{};
 
-			auto diff = curr - next - 1;
+		if (!reader.read(width, value))
+			return { 0, false };
 
-			while (diff --> 0)
-			{
-				tmp <<= 1;
-				tmp[0] = 0;
-				++l_sh;
-			}
+		return { value, true };
+	}
 
-			curr = next;
-		}
+	const char fill = 0;
 
-		while (curr --> 0)
-		{
-			tmp <<= 1;
-			tmp[0] = 0;
-			++l_sh;
-		}
+private:
+	std::uint32_t width{ 64 };
+};
+
+//Codes are written in blocks, every block uses gamma, delta, omega or fib, whichever gives it fewest bits
+//Block: 2 bit tag of coder, gamma coded number of codes, codes
+//Codes of block are kept until it is full, so flush has to be called before output is aligned
+template<>
+struct NumbersCoder<blockwise>
+{
+	//Number of codes in full block, header takes less than 30 bits of it
+	static constexpr std::size_t block_size = 4096;
 
-		if (l_sh + sh > N)
+	bool encode(BitWriter& writer, std::uint64_t value)
+	{
+		//No coder can write 0
+		if (value == 0)
 			return false;
 
-		for (int i = 0; i < l_sh; i++)
+		codes.push_back(value);
+
+		if (codes.size() == block_size)
 		{
-			data[sh] = tmp[i];
-			sh++;
+			flush(writer);
 		}
 
-
-		if (value == 0)
-			return true;
-
-		return false;
+		return true;
 	}
 
-	template<std::size_t N>
-	std::pair<std::uint64_t, bool> decode(std::bitset<N>& data, std::uint64_t& sh)
+	//Write buffered codes as one block
+	void flush(BitWriter& writer)
 	{
-		auto l_sh = sh;
+		if (codes.empty())
+			return;
 
-		//require 0 to continue reading data
-		bool req0{ false };
-		bool valid{};
-		std::uint64_t value{};
+		//Lengths of gamma, delta and omega codes depend only on binary length of value
+		std::array<std::uint64_t, 65> by_length{};
+		std::array<std::uint64_t, 4> sizes{};
 
-		while (l_sh < N)
+		for (auto value : codes)
 		{
-			if (req0 && data[l_sh] == 1)
-			{
-				valid = true;
-				break;
-			}
-			else
+			auto length = helper::bitLength(value);
+			by_length[length]++;
+			sizes[3] += fibLength(value, length);
+		}
+
+		for (std::uint32_t length = 1; length < by_length.size(); length++)
+		{
+			for (std::size_t i = 0; i < 3; i++)
 			{
-				req0 = false;
+				sizes[i] += by_length[length] * code_lengths[i][length];
 			}
-
-			if (data[l_sh] == 1)
-				req0 = true;
-			l_sh++;
 		}
 
-		if (!valid)
-			return { 0, false };
+		auto tag = static_cast<std::uint32_t>(std::min_element(sizes.begin(), sizes.end()) - sizes.begin());
 
-		auto size = l_sh - sh;
-		for (int i = 0; i < size; i++)
+		writer.write(tag, 2);
+		gamma.encode(writer, codes.size());
+
+		switch (tag)
 		{
-			if (data[sh] == 1)
-				value += fib_table[i];
-			sh++;
+		case 0:
+			encodeAll(gamma, writer);
+			break;
+		case 1:
+			encodeAll(delta, writer);
+			break;
+		case 2:
+			encodeAll(omega, writer);
+			break;
+		default:
+			encodeAll(fibonacci, writer);
+			break;
 		}
-		
-		sh++;
-		return { value, true };
+
+		codes.clear();
 	}
 
-	std::size_t bsearch(std::uint64_t val, std::size_t L, std::size_t P)
+	template<typename Source>
+	std::pair<std::uint64_t, bool> decode(BitReader<Source>& reader)
 	{
-		if (P - L < 2)
-			return L;
-
-		auto mid = (P + L) / 2;
-		if (fib_table[mid] < val)
+		if (remaining == 0)
 		{
-			return bsearch(val, mid, P);
+			//Padding at the end is zeros, so it can't hold gamma coded count
+			std::uint64_t tag_bits{};
+
+			if (!reader.read(2, tag_bits))
+				return { 0, false };
+
+			auto count = gamma.decode(reader);
+
+			if (!count.second || count.first > block_size)
+				return { 0, false };
+
+			tag = static_cast<std::uint32_t>(tag_bits);
+			remaining = count.first;
 		}
-		else if (fib_table[mid] > val)
+
+		std::pair<std::uint64_t, bool> result{};
+
+		switch (tag)
 		{
-			return bsearch(val, L, mid);
+		case 0:
+			result = gamma.decode(reader);
+			break;
+		case 1:
+			result = delta.decode(reader);
+			break;
+		case 2:
+			result = omega.decode(reader);
+			break;
+		default:
+			result = fibonacci.decode(reader);
+			break;
 		}
-		
-		return mid;
-	}	
+
+		//Broken block isn't continued by next stream
+		remaining = result.second ? remaining - 1 : 0;
+
+		return result;
+	}
 
 	const char fill = 0;
 
 private:
-	std::array<std::uint64_t, 93> fib_table{};
-	std::bitset<100> tmp{};
+	NumbersCoder<E_gamma> gamma{};
+	NumbersCoder<E_delta> delta{};
+	NumbersCoder<E_omega> omega{};
+	NumbersCoder<fib> fibonacci{};
+
+	std::vector<std::uint64_t> codes{};
+
+	//Coder and codes left of block which is decoded
+	std::uint32_t tag{};
+	std::uint64_t remaining{};
+
+	//Length of gamma, delta and omega code of values with given binary length
+	static inline const std::array<std::array<std::uint32_t, 65>, 3> code_lengths = []
+	{
+		std::array<std::array<std::uint32_t, 65>, 3> result{};
+
+		for (std::uint32_t length = 1; length < 65; length++)
+		{
+			auto value = 1ull << (length - 1);
+			result[0][length] = NumbersCoder<E_gamma>{}.codeword(value).length;
+			result[1][length] = NumbersCoder<E_delta>{}.codeword(value).length;
+			result[2][length] = NumbersCoder<E_omega>{}.codeword(value).length;
+		}
+
+		return result;
+	}();
+
+	//Fibonacci code ends after largest used number and terminating 1
+	static std::uint32_t fibLength(std::uint64_t value, std::uint32_t length)
+	{
+		if (value < helper::small_codes_size)
+			return helper::fib_encoder.small[value].length;
+
+		return helper::fib_encoder.largest(value, length) + 2;
+	}
+
+	template<typename NC>
+	void encodeAll(NC& coder, BitWriter& writer)
+	{
+		for (auto value : codes)
+		{
+			coder.encode(writer, value);
+		}
+	}
 };
+
+namespace helper
+{
+	//Align output, coder which keeps codes writes them first
+	template<typename NC>
+	void align(NC& numbers_coding, BitWriter& writer)
+	{
+		if constexpr (std::is_same_v<NC, NumbersCoder<blockwise>>)
+		{
+			numbers_coding.flush(writer);
+		}
+
+		writer.align(numbers_coding.fill);
+	}
+}